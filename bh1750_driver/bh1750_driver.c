@@ -10,6 +10,15 @@
 #define BH1750_ADDR 0x23 // Địa chỉ I2C mặc định (nếu chân ADDR nối đất)
 #define I2C_BUS_NUM 1    // Raspberry Pi 4 dùng I2C-1 (Pin 3, 5)
 
+// Bus/địa chỉ đổi được khi nạp module, vd. chạy trên i2c-stub khi test không có cảm biến:
+// modprobe i2c-stub chip_addr=0x23 && insmod bh1750_driver.ko bus=<số bus của stub>
+static int bus = I2C_BUS_NUM;
+module_param(bus, int, 0444);
+MODULE_PARM_DESC(bus, "I2C bus number (default 1)");
+static int addr = BH1750_ADDR;
+module_param(addr, int, 0444);
+MODULE_PARM_DESC(addr, "I2C address (default 0x23)");
+
 // BH1750 Instructions
 #define POWER_ON 0x01
 #define RESET 0x07
@@ -22,9 +31,17 @@ static int major_number;
 static struct class *bh1750_class = NULL;
 static struct device *bh1750_device = NULL;
 
-// Hàm gửi lệnh xuống cảm biến
+// Adapter chỉ hỗ trợ SMBus (i2c-stub) không có truyền I2C thô
+static bool bh1750_raw_i2c(struct i2c_client *client) {
+    return i2c_check_functionality(client->adapter, I2C_FUNC_I2C);
+}
+
+// Hàm gửi lệnh xuống cảm biến, trả về 1 (số byte đã gửi) nếu thành công
 static int bh1750_write_cmd(struct i2c_client *client, u8 cmd) {
-    return i2c_master_send(client, &cmd, 1);
+    int ret;
+    if (bh1750_raw_i2c(client)) return i2c_master_send(client, &cmd, 1);
+    ret = i2c_smbus_write_byte(client, cmd);
+    return ret < 0 ? ret : 1;
 }
 
 // Hàm đọc Lux từ cảm biến
@@ -35,8 +52,16 @@ static int bh1750_read_lux(u16 *raw_val) {
     if (!bh1750_client) return -ENODEV;
 
     // Đọc 2 byte dữ liệu
-    ret = i2c_master_recv(bh1750_client, buf, 2);
-    if (ret < 0) return ret;
+    if (bh1750_raw_i2c(bh1750_client)) {
+        ret = i2c_master_recv(bh1750_client, buf, 2);
+        if (ret < 0) return ret;
+    } else {
+        // i2c-stub: giá trị đặt sẵn ở thanh ghi 0 (i2cset -y <bus> 0x23 0x00 0x1234 w)
+        ret = i2c_smbus_read_word_swapped(bh1750_client, 0x00);
+        if (ret < 0) return ret;
+        buf[0] = ret >> 8;
+        buf[1] = ret & 0xff;
+    }
     
     // Công thức: Lux = (High_Byte << 8 | Low_Byte) / 1.2
     *raw_val = ((buf[0] << 8) | buf[1]); 
@@ -48,13 +73,13 @@ static ssize_t dev_read(struct file *file, char __user *user_buf, size_t count,
     u16 raw = 0;
     u32 int_part, dec_part;
     char out_buf[32];
-    int len;
+    int len, ret;
 
     if (*ppos > 0) return 0; // EOF
 
-    if (bh1750_read_lux(&raw) < 0) {
-        return -EFAULT;
-    }
+    // Trả về mã lỗi I2C thật (-EIO, -ENXIO, -ETIMEDOUT...) để phân biệt được lỗi bus
+    ret = bh1750_read_lux(&raw);
+    if (ret < 0) return ret;
 
     int_part = (raw * 10) / 12;
     dec_part = ((raw * 10) % 12) * 100 / 12;
@@ -82,9 +107,9 @@ static int __init bh1750_init(void) {
 
     // 2. Kết nối I2C Thủ công (Không cần Device Tree)
     // Lấy Adapter I2C số 1
-    bh1750_adapter = i2c_get_adapter(I2C_BUS_NUM);
+    bh1750_adapter = i2c_get_adapter(bus);
     if (!bh1750_adapter) {
-        printk(KERN_ERR "BH1750: Cannot get I2C adapter %d\n", I2C_BUS_NUM);
+        printk(KERN_ERR "BH1750: Cannot get I2C adapter %d\n", bus);
         return -ENODEV;
     }
 
@@ -92,6 +117,7 @@ static int __init bh1750_init(void) {
     struct i2c_board_info board_info = {
         I2C_BOARD_INFO("bh1750", BH1750_ADDR)
     };
+    board_info.addr = addr;
     bh1750_client = i2c_new_client_device(bh1750_adapter, &board_info);
 
     if (!bh1750_client) {
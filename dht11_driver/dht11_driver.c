@@ -2,26 +2,70 @@
 #include <linux/kernel.h>
 #include <linux/init.h>
 #include <linux/fs.h>
+#include <linux/cdev.h>
 #include <linux/gpio.h>
+#include <linux/gpio/consumer.h>
+#include <linux/platform_device.h>
+#include <linux/of.h>
+#include <linux/idr.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
 #include <linux/delay.h>
 #include <linux/uaccess.h>
 #include <linux/device.h>
 #include <linux/interrupt.h>
+#include <linux/ktime.h>
+#include <linux/version.h>
 
 #define DEVICE_NAME "dht11"
-#define GPIO_PIN 538  // Dùng GPIO 26 (Pin 37) để tránh xung đột SPI/I2C
+#define DHT11_MAX_DEVICES 8
+#define DHT11_DEFAULT_GPIO 538  // GPIO 26 (Pin 37), dùng khi không có tham số gpios= (default_gpio=)
 
-static int major_number;
+// Mỗi cảm biến có GPIO, khóa và node /dev/dht11-N riêng.
+// Cấp phát thường (không devm) và giải phóng trong release của dev: fd còn mở sau khi
+// gỡ cảm biến (unbind) vẫn giữ struct qua cdev -> dev, chỉ đọc ra -ENODEV.
+struct dht11_dev {
+    struct gpio_desc *gpiod; // NULL khi cảm biến đã bị gỡ
+    struct mutex lock;
+    struct cdev cdev;
+    struct device dev;
+    int minor;
+    int legacy_gpio; // Số GPIO cũ (tham số module), -1 nếu lấy từ Device Tree
+    u64 irq_off_last_ns; // Thời gian tắt ngắt của lần đọc gần nhất / lớn nhất (sysfs, cho sensor_bench)
+    u64 irq_off_max_ns;
+};
+
+static dev_t dht11_devt;
 static struct class *dht11_class = NULL;
-static struct device *dht11_device = NULL;
+static DEFINE_IDA(dht11_minor_ida);
+
+// Danh sách GPIO cho board không có Device Tree: insmod dht11_driver.ko gpios=538,539
+static int gpios[DHT11_MAX_DEVICES];
+static int num_gpios = 0;
+module_param_array(gpios, int, &num_gpios, 0444);
+MODULE_PARM_DESC(gpios, "Legacy GPIO numbers of DHT11 sensors (one /dev/dht11-N per entry)");
+
+// Không có gpios=: một cảm biến ở GPIO này. Board dùng Device Tree đặt default_gpio=-1.
+// Chỉ dựa vào tham số, không vào số cảm biến DT đã probe (probe có thể deferred/async, chạy sau init)
+static int default_gpio = DHT11_DEFAULT_GPIO;
+module_param(default_gpio, int, 0444);
+MODULE_PARM_DESC(default_gpio, "GPIO used when gpios= is not given, -1 for none (Device Tree boards)");
+
+static struct dht11_dev *legacy_devs[DHT11_MAX_DEVICES];
+static int legacy_count = 0;
 
 // --- HÀM HỖ TRỢ (Mô phỏng logic của BBB) ---
 
+// GPIO chip có thể ngủ (gpio-sim, expander I2C) không đọc được khi tắt ngắt
+static int dht11_get(struct gpio_desc *gpiod) {
+    return gpiod_cansleep(gpiod) ? gpiod_get_value_cansleep(gpiod) : gpiod_get_value(gpiod);
+}
+
 // Chờ chân GPIO chuyển sang trạng thái mong muốn (expected)
 // Trả về 0 nếu OK, -1 nếu timeout
-static int wait_for_state(int expected, int timeout_us) {
+static int wait_for_state(struct gpio_desc *gpiod, int expected, int timeout_us) {
     int waited = 0;
-    while (gpio_get_value(GPIO_PIN) != expected) {
+    while (dht11_get(gpiod) != expected) {
         udelay(1);
         waited++;
         if (waited > timeout_us) return -1;
@@ -29,106 +73,150 @@ static int wait_for_state(int expected, int timeout_us) {
     return 0;
 }
 
-// Hàm đọc dữ liệu chính
-static int read_dht11_data(u8 *h_int, u8 *h_dec, u8 *t_int, u8 *t_dec) {
-    u8 bits[5] = {0};
-    int i, j, ret;
-    unsigned long flags;
-
-    // 1. Gửi tín hiệu Start (Host kéo thấp 20ms)
-    gpio_direction_output(GPIO_PIN, 0);
-    mdelay(20);
-    gpio_set_value(GPIO_PIN, 1);
-    udelay(30);
-    gpio_direction_input(GPIO_PIN);
-
-    // --- BẮT ĐẦU ĐOẠN QUAN TRỌNG (Tắt ngắt hệ thống) ---
-    // Raspberry Pi chạy Linux đa nhiệm, nếu không tắt ngắt,
-    // hệ điều hành sẽ chen ngang làm sai lệch thời gian đọc micro giây.
-    local_irq_save(flags);
+// Nhận 40 bit từ cảm biến (gọi khi đã tắt ngắt)
+static int read_dht11_bits(struct gpio_desc *gpiod, u8 *bits) {
+    int i, j;
 
     // 2. Chờ Sensor phản hồi (Start sequence)
     // Sensor kéo thấp 80us
-    if ((ret = wait_for_state(0, 100)) < 0) {
-        local_irq_restore(flags);
-        return -1; // Timeout wait start low
-    }
+    if (wait_for_state(gpiod, 0, 100) < 0) return -1; // Timeout wait start low
     // Sensor kéo cao 80us
-    if ((ret = wait_for_state(1, 100)) < 0) {
-        local_irq_restore(flags);
-        return -2; // Timeout wait start high
-    }
+    if (wait_for_state(gpiod, 1, 100) < 0) return -2; // Timeout wait start high
     // Sensor bắt đầu gửi bit (kéo thấp 50us)
-    if ((ret = wait_for_state(0, 100)) < 0) {
-        local_irq_restore(flags);
-        return -3; // Timeout wait first bit
-    }
+    if (wait_for_state(gpiod, 0, 100) < 0) return -3; // Timeout wait first bit
 
     // 3. Đọc 40 bits (5 bytes)
     for (j = 0; j < 5; j++) {
         for (i = 0; i < 8; i++) {
             // Chờ cạnh lên (bắt đầu bit data)
-            if ((ret = wait_for_state(1, 100)) < 0) {
-                local_irq_restore(flags);
-                return -4;
-            }
-            
+            if (wait_for_state(gpiod, 1, 100) < 0) return -4;
+
             // Logic phân biệt 0 và 1:
             // Bit 0: High ~26-28us
             // Bit 1: High ~70us
             // Ta đợi 40us rồi kiểm tra. Nếu vẫn High -> Là bit 1.
             udelay(40);
-            
-            if (gpio_get_value(GPIO_PIN)) {
+
+            if (dht11_get(gpiod)) {
                 bits[j] |= (1 << (7 - i));
                 // Chờ cho chân xuống Low trở lại để đón bit tiếp theo
-                if ((ret = wait_for_state(0, 100)) < 0) {
-                    local_irq_restore(flags);
-                    return -5;
-                }
+                if (wait_for_state(gpiod, 0, 100) < 0) return -5;
             }
             // Nếu gpio == 0 thì là bit 0, vòng lặp tự quay lại chờ cạnh lên tiếp theo
         }
     }
+    return 0;
+}
 
-    local_irq_restore(flags);
+// Hàm đọc dữ liệu chính (gọi khi đã giữ dht->lock)
+static int read_dht11_data(struct dht11_dev *dht, u8 *h_int, u8 *h_dec, u8 *t_int, u8 *t_dec) {
+    struct gpio_desc *gpiod = dht->gpiod;
+    u8 bits[5] = {0};
+    int ret;
+    unsigned long flags;
+    u64 t0;
+
+    // 1. Gửi tín hiệu Start (Host kéo thấp 20ms)
+    // msleep thay cho mdelay để CPU còn phục vụ các cảm biến khác trong lúc chờ
+    gpiod_direction_output(gpiod, 0);
+    msleep(20);
+    gpiod_set_value_cansleep(gpiod, 1); // process context, được cả với chip GPIO có thể ngủ
+    udelay(30);
+    gpiod_direction_input(gpiod);
+
+    // --- BẮT ĐẦU ĐOẠN QUAN TRỌNG (Tắt ngắt hệ thống) ---
+    // Raspberry Pi chạy Linux đa nhiệm, nếu không tắt ngắt,
+    // hệ điều hành sẽ chen ngang làm sai lệch thời gian đọc micro giây.
+    // Chỉ tắt ngắt trên CPU hiện tại, nên các cảm biến khác vẫn đọc song song trên CPU khác.
+    // Chip GPIO có thể ngủ (gpio-sim khi test) thì đọc với ngắt bật, không có số liệu tắt ngắt
+    if (gpiod_cansleep(gpiod)) {
+        ret = read_dht11_bits(gpiod, bits);
+    } else {
+        local_irq_save(flags);
+        t0 = ktime_get_ns();
+        ret = read_dht11_bits(gpiod, bits);
+        dht->irq_off_last_ns = ktime_get_ns() - t0;
+        local_irq_restore(flags);
+        if (dht->irq_off_last_ns > dht->irq_off_max_ns) dht->irq_off_max_ns = dht->irq_off_last_ns;
+    }
     // --- KẾT THÚC ĐOẠN QUAN TRỌNG ---
+    if (ret < 0) return ret;
 
     // 4. Kiểm tra Checksum
     if ((bits[0] + bits[1] + bits[2] + bits[3]) == bits[4]) {
         *h_int = bits[0];
-        *h_dec = bits[1]; 
-        *t_int = bits[2]; 
+        *h_dec = bits[1];
+        *t_int = bits[2];
         *t_dec = bits[3];
         return 0; // Success
     }
-    
+
     return -10; // Checksum error
 }
 
 static ssize_t dht11_read(struct file *file, char __user *user_buf, size_t count, loff_t *ppos) {
+    struct dht11_dev *dht = file->private_data;
     u8 hi = 0, hd = 0, ti = 0, td = 0;
     char result_buf[64];
     int ret, len;
 
     if (*ppos > 0) return 0;
 
-    ret = read_dht11_data(&hi, &hd, &ti, &td);
-    
+    // Khóa riêng từng cảm biến: hai lần đọc cùng một chân GPIO sẽ phá giao thức,
+    // còn các cảm biến khác nhau không chờ nhau.
+    if (mutex_lock_interruptible(&dht->lock)) return -ERESTARTSYS;
+    if (!dht->gpiod) {
+        mutex_unlock(&dht->lock);
+        return -ENODEV;
+    }
+    ret = read_dht11_data(dht, &hi, &hd, &ti, &td);
+    mutex_unlock(&dht->lock);
+
     if (ret == 0) {
         len = sprintf(result_buf, "Temp: %d.%d C, Hum: %d.%d %%\n", ti, td, hi, hd);
     } else {
         len = sprintf(result_buf, "Error reading DHT11: Code %d\n", ret);
     }
 
+    if (len > count) len = count;
     if (copy_to_user(user_buf, result_buf, len)) return -EFAULT;
     *ppos += len;
     return len;
 }
 
-static int dht11_open(struct inode *inode, struct file *file) { return 0; }
+static int dht11_open(struct inode *inode, struct file *file) {
+    file->private_data = container_of(inode->i_cdev, struct dht11_dev, cdev);
+    return 0;
+}
 static int dht11_release(struct inode *inode, struct file *file) { return 0; }
 
+// /sys/class/dht11_class/dht11-N/irq_off_{last,max}_us, ghi bất kỳ giá trị vào irq_off_max_us để đặt lại
+static ssize_t irq_off_last_us_show(struct device *dev, struct device_attribute *attr, char *buf) {
+    struct dht11_dev *dht = dev_get_drvdata(dev);
+    return sprintf(buf, "%llu\n", div_u64(dht->irq_off_last_ns, 1000));
+}
+static DEVICE_ATTR_RO(irq_off_last_us);
+
+static ssize_t irq_off_max_us_show(struct device *dev, struct device_attribute *attr, char *buf) {
+    struct dht11_dev *dht = dev_get_drvdata(dev);
+    return sprintf(buf, "%llu\n", div_u64(dht->irq_off_max_ns, 1000));
+}
+static ssize_t irq_off_max_us_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count) {
+    struct dht11_dev *dht = dev_get_drvdata(dev);
+    mutex_lock(&dht->lock);
+    dht->irq_off_max_ns = 0;
+    mutex_unlock(&dht->lock);
+    return count;
+}
+static DEVICE_ATTR_RW(irq_off_max_us);
+
+static struct attribute *dht11_attrs[] = {
+    &dev_attr_irq_off_last_us.attr,
+    &dev_attr_irq_off_max_us.attr,
+    NULL
+};
+ATTRIBUTE_GROUPS(dht11);
+
 static struct file_operations fops = {
     .owner = THIS_MODULE,
     .read = dht11_read,
@@ -136,55 +224,203 @@ static struct file_operations fops = {
     .release = dht11_release,
 };
 
-static int __init dht11_init(void) {
+// Fd cuối cùng đã đóng và cảm biến đã gỡ: trả minor, giải phóng
+static void dht11_dev_release(struct device *dev) {
+    struct dht11_dev *dht = container_of(dev, struct dht11_dev, dev);
+
+    ida_free(&dht11_minor_ida, dht->minor);
+    kfree(dht);
+}
+
+// Cấp minor, đăng ký cdev và tạo /dev/dht11-N cho một cảm biến đã có GPIO.
+// Lỗi: GPIO vẫn thuộc người gọi
+static struct dht11_dev *dht11_create(struct gpio_desc *gpiod, int legacy_gpio, struct device *parent) {
+    struct dht11_dev *dht;
+    int ret;
+
+    dht = kzalloc(sizeof(*dht), GFP_KERNEL);
+    if (!dht) return ERR_PTR(-ENOMEM);
+
+    dht->minor = ida_alloc_max(&dht11_minor_ida, DHT11_MAX_DEVICES - 1, GFP_KERNEL);
+    if (dht->minor < 0) {
+        ret = dht->minor;
+        kfree(dht);
+        return ERR_PTR(ret);
+    }
+    dht->gpiod = gpiod;
+    dht->legacy_gpio = legacy_gpio;
+    mutex_init(&dht->lock);
+
+    // Từ đây dht thuộc dev: lỗi thì put_device, release dọn minor và bộ nhớ
+    device_initialize(&dht->dev);
+    dht->dev.class = dht11_class;
+    dht->dev.parent = parent;
+    dht->dev.devt = MKDEV(MAJOR(dht11_devt), dht->minor);
+    dht->dev.groups = dht11_groups;
+    dht->dev.release = dht11_dev_release;
+    dev_set_drvdata(&dht->dev, dht);
+    ret = dev_set_name(&dht->dev, DEVICE_NAME "-%d", dht->minor);
+    if (ret == 0) {
+        cdev_init(&dht->cdev, &fops);
+        dht->cdev.owner = THIS_MODULE;
+        // cdev giữ tham chiếu tới dev: mỗi fd mở giữ dht sống
+        ret = cdev_device_add(&dht->cdev, &dht->dev);
+    }
+    if (ret) {
+        put_device(&dht->dev);
+        return ERR_PTR(ret);
+    }
+    return dht;
+}
+
+// Gỡ node và trả GPIO ngay; bộ nhớ đợi fd cuối cùng (dht11_dev_release)
+static void dht11_destroy(struct dht11_dev *dht) {
+    cdev_device_del(&dht->cdev, &dht->dev);
+
+    mutex_lock(&dht->lock);
+    if (dht->legacy_gpio >= 0) {
+        // QUAN TRỌNG: Giải phóng GPIO để lần sau nạp không bị báo Busy
+        gpio_free(dht->legacy_gpio);
+    } else {
+        gpiod_put(dht->gpiod);
+    }
+    dht->gpiod = NULL;
+    mutex_unlock(&dht->lock);
+
+    put_device(&dht->dev);
+}
+
+// --- DEVICE TREE: mỗi node compatible = "datn,dht11" là một cảm biến ---
+// dht11@0 { compatible = "datn,dht11"; gpios = <&gpio 26 GPIO_ACTIVE_HIGH>; };
+// (nạp module với default_gpio=-1 để không có thêm cảm biến ở GPIO mặc định)
+static int dht11_probe(struct platform_device *pdev) {
+    struct dht11_dev *dht;
+    struct gpio_desc *gpiod;
+
+    // Không dùng devm: GPIO phải còn đến khi dht11_destroy đánh dấu cảm biến đã gỡ
+    gpiod = gpiod_get(&pdev->dev, NULL, GPIOD_IN);
+    if (IS_ERR(gpiod)) {
+        dev_err(&pdev->dev, "Cannot get GPIO. Error: %ld\n", PTR_ERR(gpiod));
+        return PTR_ERR(gpiod);
+    }
+
+    dht = dht11_create(gpiod, -1, &pdev->dev);
+    if (IS_ERR(dht)) {
+        gpiod_put(gpiod);
+        return PTR_ERR(dht);
+    }
+
+    platform_set_drvdata(pdev, dht);
+    dev_info(&pdev->dev, "DHT11 registered at /dev/" DEVICE_NAME "-%d\n", dht->minor);
+    return 0;
+}
+
+// Kernel 6.11 đổi kiểu trả về của .remove sang void
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 11, 0)
+static void dht11_remove(struct platform_device *pdev) {
+#else
+static int dht11_remove(struct platform_device *pdev) {
+#endif
+    dht11_destroy(platform_get_drvdata(pdev));
+#if LINUX_VERSION_CODE < KERNEL_VERSION(6, 11, 0)
+    return 0;
+#endif
+}
+
+static const struct of_device_id dht11_of_match[] = {
+    { .compatible = "datn,dht11" },
+    { }
+};
+MODULE_DEVICE_TABLE(of, dht11_of_match);
+
+static struct platform_driver dht11_platform_driver = {
+    .probe = dht11_probe,
+    .remove = dht11_remove,
+    .driver = {
+        .name = DEVICE_NAME,
+        .of_match_table = dht11_of_match,
+    },
+};
+
+// --- THAM SỐ MODULE: GPIO số cũ, chuyển sang descriptor ngay sau khi request ---
+static int dht11_add_legacy(int gpio) {
+    struct dht11_dev *dht;
     int ret;
-    
-    // 1. Request GPIO - Bước quan trọng để tránh lỗi Busy
-    if (!gpio_is_valid(GPIO_PIN)) {
-        printk(KERN_ERR "DHT11: Invalid GPIO %d\n", GPIO_PIN);
+
+    if (!gpio_is_valid(gpio)) {
+        printk(KERN_ERR "DHT11: Invalid GPIO %d\n", gpio);
         return -ENODEV;
     }
-    
+
     // Request GPIO và set luôn giá trị mặc định là INPUT
-    ret = gpio_request_one(GPIO_PIN, GPIOF_IN, "DHT11_Sensor");
+    ret = gpio_request_one(gpio, GPIOF_IN, "DHT11_Sensor");
     if (ret) {
-        printk(KERN_ERR "DHT11: Cannot request GPIO %d. Error: %d\n", GPIO_PIN, ret);
-        return ret; // Trả về lỗi để insmod thất bại (đúng chuẩn)
+        printk(KERN_ERR "DHT11: Cannot request GPIO %d. Error: %d\n", gpio, ret);
+        return ret;
     }
 
-    // 2. Register Device
-    major_number = register_chrdev(0, DEVICE_NAME, &fops);
-    if (major_number < 0) {
-        gpio_free(GPIO_PIN);
-        return major_number;
+    dht = dht11_create(gpio_to_desc(gpio), gpio, NULL);
+    if (IS_ERR(dht)) {
+        gpio_free(gpio);
+        return PTR_ERR(dht);
     }
 
+    legacy_devs[legacy_count++] = dht;
+    printk(KERN_INFO "DHT11: GPIO %d registered at /dev/" DEVICE_NAME "-%d\n", gpio, dht->minor);
+    return 0;
+}
+
+static void dht11_remove_legacy(void) {
+    while (legacy_count > 0) dht11_destroy(legacy_devs[--legacy_count]);
+}
+
+static int __init dht11_init(void) {
+    int ret, i;
+
+    // 1. Xin một dải minor cho tối đa DHT11_MAX_DEVICES cảm biến
+    ret = alloc_chrdev_region(&dht11_devt, 0, DHT11_MAX_DEVICES, DEVICE_NAME);
+    if (ret) return ret;
+
     dht11_class = class_create("dht11_class");
     if (IS_ERR(dht11_class)) {
-        unregister_chrdev(major_number, DEVICE_NAME);
-        gpio_free(GPIO_PIN);
+        unregister_chrdev_region(dht11_devt, DHT11_MAX_DEVICES);
         return PTR_ERR(dht11_class);
     }
 
-    dht11_device = device_create(dht11_class, NULL, MKDEV(major_number, 0), NULL, DEVICE_NAME);
-    if (IS_ERR(dht11_device)) {
+    // 2. Cảm biến khai báo trong Device Tree
+    ret = platform_driver_register(&dht11_platform_driver);
+    if (ret) {
         class_destroy(dht11_class);
-        unregister_chrdev(major_number, DEVICE_NAME);
-        gpio_free(GPIO_PIN);
-        return PTR_ERR(dht11_device);
+        unregister_chrdev_region(dht11_devt, DHT11_MAX_DEVICES);
+        return ret;
+    }
+
+    // 3. Cảm biến khai báo qua tham số gpios=
+    for (i = 0; i < num_gpios; i++) {
+        ret = dht11_add_legacy(gpios[i]);
+        if (ret) {
+            // Trả về lỗi để insmod thất bại (đúng chuẩn)
+            dht11_remove_legacy();
+            platform_driver_unregister(&dht11_platform_driver);
+            class_destroy(dht11_class);
+            unregister_chrdev_region(dht11_devt, DHT11_MAX_DEVICES);
+            return ret;
+        }
     }
 
-    printk(KERN_INFO "DHT11: Driver loaded on GPIO %d (Standard Logic)\n", GPIO_PIN);
+    // 4. Không có gpios=: GPIO mặc định. Không bắt buộc (chân có thể đã thuộc cảm biến Device Tree)
+    if (num_gpios == 0 && default_gpio >= 0 && dht11_add_legacy(default_gpio))
+        printk(KERN_WARNING "DHT11: Default GPIO %d not registered (gpios= or default_gpio=-1 to silence)\n", default_gpio);
+
+    printk(KERN_INFO "DHT11: Driver loaded, %d legacy sensor(s)\n", legacy_count);
     return 0;
 }
 
 static void __exit dht11_exit(void) {
-    device_destroy(dht11_class, MKDEV(major_number, 0));
+    dht11_remove_legacy();
+    platform_driver_unregister(&dht11_platform_driver);
     class_destroy(dht11_class);
-    unregister_chrdev(major_number, DEVICE_NAME);
-    
-    // QUAN TRỌNG: Giải phóng GPIO để lần sau nạp không bị báo Busy
-    gpio_free(GPIO_PIN);
+    unregister_chrdev_region(dht11_devt, DHT11_MAX_DEVICES);
     printk(KERN_INFO "DHT11: Driver unloaded\n");
 }
 
@@ -0,0 +1,58 @@
+// Throughput benchmark and cross-check of the batch feature kernels.
+// Usage: bench_features [-d days] [-s stride] [-r repeats]
+// Synthesizes `days` of 10 s samples, extracts every window with each ISA
+// available on this CPU, and compares the outputs bit for bit with the scalar path.
+#include "featurekernels.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#define SAMPLES_PER_DAY (24 * 360)
+#define QUANT_SCALE 0.35f
+#define QUANT_ZERO_POINT -20
+
+static double nowSec() { struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts); return ts.tv_sec + ts.tv_nsec * 1e-9; }
+
+int main(int argc, char *argv[]) {
+    int days = 30, stride = 1, repeats = 5, opt;
+    while ((opt = getopt(argc, argv, "d:s:r:")) != -1) {
+        if (opt == 'd') days = atoi(optarg); else if (opt == 's') stride = atoi(optarg); else if (opt == 'r') repeats = atoi(optarg);
+        else { fprintf(stderr, "Usage: %s [-d days] [-s stride] [-r repeats]\n", argv[0]); return 2; }
+    }
+    if (days < 1 || stride < 1 || repeats < 1) { fprintf(stderr, "days, stride and repeats must be >= 1\n"); return 2; }
+
+    // Same columns as the model window: min_sin, min_cos, temp, humid, lux
+    int rows = days * SAMPLES_PER_DAY;
+    std::vector<float> col[RAW_FEATURE_COUNT]; for (int c = 0; c < RAW_FEATURE_COUNT; c++) col[c].resize(rows);
+    srand(1);
+    for (int r = 0; r < rows; r++) {
+        float minute = (r % SAMPLES_PER_DAY) / 6.0f; float noise = (rand() % 1000) / 1000.0f - 0.5f;
+        col[0][r] = sinf(2 * M_PI * minute / 1440.0f); col[1][r] = cosf(2 * M_PI * minute / 1440.0f);
+        col[2][r] = 28.0f + 3.0f * col[0][r] + noise; col[3][r] = 65.0f - 8.0f * col[0][r] + 2 * noise; col[4][r] = fmaxf(0.0f, 400.0f * col[1][r]) + 10 * noise;
+    }
+    const float *cols[RAW_FEATURE_COUNT]; for (int c = 0; c < RAW_FEATURE_COUNT; c++) cols[c] = col[c].data();
+    int windows = (rows - WINDOW_LEN) / stride + 1;
+    printf("%d days, %d rows, %d windows (stride %d), %d repeats, default ISA: %s\n", days, rows, windows, stride, repeats, featureIsaName(featureIsa()));
+
+    std::vector<float> ref((size_t)windows * MODEL_INPUT_COUNT), out(ref.size());
+    std::vector<int8_t> refQ(ref.size()), outQ(ref.size());
+    setFeatureIsa(ISA_SCALAR); extractFeaturesBatch(cols, windows, stride, ref.data()); quantizeInt8(ref.data(), ref.size(), QUANT_SCALE, QUANT_ZERO_POINT, refQ.data());
+
+    double scalarRate = 0; int failures = 0;
+    printf("%-8s %14s %10s %16s %10s\n", "isa", "windows/s", "speedup", "quantize Mval/s", "identical");
+    for (int i = ISA_SCALAR; i <= ISA_NEON; i++) {
+        FeatureIsa isa = (FeatureIsa)i; if (!setFeatureIsa(isa)) continue;
+        double t0 = nowSec(); for (int r = 0; r < repeats; r++) extractFeaturesBatch(cols, windows, stride, out.data()); double tf = (nowSec() - t0) / repeats;
+        t0 = nowSec(); for (int r = 0; r < repeats; r++) quantizeInt8(out.data(), out.size(), QUANT_SCALE, QUANT_ZERO_POINT, outQ.data()); double tq = (nowSec() - t0) / repeats;
+        double rate = windows / tf; if (isa == ISA_SCALAR) scalarRate = rate;
+        bool same = memcmp(out.data(), ref.data(), out.size() * sizeof(float)) == 0 && memcmp(outQ.data(), refQ.data(), outQ.size()) == 0;
+        if (!same) failures++;
+        printf("%-8s %14.0f %9.2fx %16.1f %10s\n", featureIsaName(isa), rate, rate / scalarRate, out.size() / tq / 1e6, same ? "yes" : "NO");
+    }
+    return failures ? 1 : 0;
+}
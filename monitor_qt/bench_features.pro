@@ -0,0 +1,12 @@
+TARGET = bench_features
+TEMPLATE = app
+CONFIG += c++17 console
+CONFIG -= qt app_bundle
+
+OBJECTS_DIR = .obj/bench
+
+# Chỉ cần nhân feature, không Qt/TFLite
+SOURCES += bench_features.cpp \
+           featurekernels.cpp
+
+HEADERS += featurekernels.h
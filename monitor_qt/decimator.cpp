@@ -0,0 +1,26 @@
+#include "decimator.h"
+#include <algorithm>
+#include <math.h>
+
+#define OUTLIER_MAD_K 3.0f   // reject |x - median| > K * 1.4826 * MAD
+
+float Decimator::median(std::vector<float> &values) {
+    size_t n = values.size(); std::sort(values.begin(), values.end());
+    return (n % 2) ? values[n / 2] : 0.5f * (values[n / 2 - 1] + values[n / 2]);
+}
+
+bool Decimator::reduce(float *out) {
+    if (samples.empty()) return false;
+    std::vector<float> sorted = samples; samples.clear();
+    float med = median(sorted);
+    if (mode == DECIMATE_MEDIAN || sorted.size() < 3) { *out = med; return true; }
+
+    std::vector<float> dev; dev.reserve(sorted.size());
+    for (float v : sorted) dev.push_back(fabsf(v - med));
+    float limit = OUTLIER_MAD_K * 1.4826f * median(dev);
+    if (limit == 0.0f) { *out = med; return true; } // most samples identical
+    float sum = 0.0f; int kept = 0;
+    for (float v : sorted) { if (fabsf(v - med) <= limit) { sum += v; kept++; } }
+    *out = kept ? sum / kept : med;
+    return true;
+}
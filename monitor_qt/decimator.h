@@ -0,0 +1,30 @@
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include <vector>
+
+enum DecimationMode {
+    DECIMATE_MEDIAN,
+    DECIMATE_MEAN_REJECT   // mean after dropping samples far from the median (MAD test)
+};
+
+// Collects the samples of one channel between two model ticks and reduces them to one value
+class Decimator
+{
+public:
+    explicit Decimator(DecimationMode mode = DECIMATE_MEDIAN) : mode(mode) {}
+
+    void setMode(DecimationMode m) { mode = m; }
+    void push(float value) { samples.push_back(value); }
+    int count() const { return (int)samples.size(); }
+    // Returns false if nothing was collected; always empties the accumulator
+    bool reduce(float *out);
+
+    static float median(std::vector<float> &values);
+
+private:
+    DecimationMode mode;
+    std::vector<float> samples;
+};
+
+#endif // DECIMATOR_H
@@ -0,0 +1,233 @@
+#include "featurekernels.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#endif
+
+#if defined(__aarch64__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HAVE_NEON 1
+#if !defined(__aarch64__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#endif
+
+static const char* ISA_NAMES[] = {"scalar", "sse2", "avx2", "neon"};
+
+// ============================================================================
+//  SCALAR (reference, same arithmetic as ZonePipeline::computeFeatures)
+// ============================================================================
+
+static inline void storeColumn(float *out, int c, float sum, float min_val, float max_val, float ma6_sum) {
+    out[c * 4 + 0] = sum / WINDOW_LEN; out[c * 4 + 1] = min_val; out[c * 4 + 2] = max_val; out[c * 4 + 3] = ma6_sum / MA_WINDOW;
+}
+
+static void windowScalar(const float *const cols[], int start, float *out) {
+    for (int c = 0; c < RAW_FEATURE_COUNT; c++) {
+        const float *p = cols[c] + start;
+        float sum = 0.0f; float min_val = FLT_MAX; float max_val = -FLT_MAX; float ma6_sum = 0.0f;
+        for (int i = 0; i < WINDOW_LEN; i++) { float val = p[i]; sum += val; if (val < min_val) min_val = val; if (val > max_val) max_val = val; if (i >= WINDOW_LEN - MA_WINDOW) ma6_sum += val; }
+        storeColumn(out, c, sum, min_val, max_val, ma6_sum);
+    }
+}
+
+static inline int8_t quantizeOne(float x, float scale, int32_t zero_point) {
+    float quant_val = (x / scale) + zero_point; if (quant_val > 127) quant_val = 127; if (quant_val < -128) quant_val = -128;
+    return (int8_t)roundf(quant_val);
+}
+
+// ============================================================================
+//  SSE2 / AVX2: one window per lane, 4 or 8 windows per pass
+//  min/max operands are ordered so that ties and NaN behave like the scalar if()
+// ============================================================================
+
+#ifdef HAVE_X86_SIMD
+static inline __m128 loadLanesSse(const float *p, int stride) {
+    return stride == 1 ? _mm_loadu_ps(p) : _mm_set_ps(p[3 * stride], p[2 * stride], p[stride], p[0]);
+}
+
+static void windowsSse2(const float *const cols[], int start, int stride, float *out) {
+    float s[4], mn[4], mx[4], ma[4];
+    for (int c = 0; c < RAW_FEATURE_COUNT; c++) {
+        const float *p = cols[c] + start;
+        __m128 vsum = _mm_setzero_ps(), vmin = _mm_set1_ps(FLT_MAX), vmax = _mm_set1_ps(-FLT_MAX), vma = _mm_setzero_ps();
+        for (int i = 0; i < WINDOW_LEN; i++) {
+            __m128 v = loadLanesSse(p + i, stride);
+            vsum = _mm_add_ps(vsum, v); vmin = _mm_min_ps(v, vmin); vmax = _mm_max_ps(v, vmax);
+            if (i >= WINDOW_LEN - MA_WINDOW) vma = _mm_add_ps(vma, v);
+        }
+        _mm_storeu_ps(s, vsum); _mm_storeu_ps(mn, vmin); _mm_storeu_ps(mx, vmax); _mm_storeu_ps(ma, vma);
+        for (int k = 0; k < 4; k++) storeColumn(out + k * MODEL_INPUT_COUNT, c, s[k], mn[k], mx[k], ma[k]);
+    }
+}
+
+// trunc + exact fraction test = roundf() (half away from zero) for |q| <= 128
+static inline __m128i roundLanesSse(__m128 q) {
+    __m128i t = _mm_cvttps_epi32(q); __m128 frac = _mm_sub_ps(q, _mm_cvtepi32_ps(t));
+    t = _mm_sub_epi32(t, _mm_castps_si128(_mm_cmpge_ps(frac, _mm_set1_ps(0.5f))));
+    t = _mm_add_epi32(t, _mm_castps_si128(_mm_cmple_ps(frac, _mm_set1_ps(-0.5f))));
+    return t;
+}
+
+static int quantizeSse2(const float *in, int n, float scale, int32_t zero_point, int8_t *out) {
+    __m128 vscale = _mm_set1_ps(scale), vzp = _mm_set1_ps((float)zero_point), hi = _mm_set1_ps(127), lo = _mm_set1_ps(-128);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 q = _mm_add_ps(_mm_div_ps(_mm_loadu_ps(in + i), vscale), vzp);
+        q = _mm_max_ps(lo, _mm_min_ps(hi, q));
+        __m128i t = roundLanesSse(q); t = _mm_packs_epi32(t, t); t = _mm_packs_epi16(t, t);
+        int32_t packed = _mm_cvtsi128_si32(t); memcpy(out + i, &packed, 4);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static void windowsAvx2(const float *const cols[], int start, int stride, float *out) {
+    float s[8], mn[8], mx[8], ma[8];
+    __m256i gatherIdx = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+    for (int c = 0; c < RAW_FEATURE_COUNT; c++) {
+        const float *p = cols[c] + start;
+        __m256 vsum = _mm256_setzero_ps(), vmin = _mm256_set1_ps(FLT_MAX), vmax = _mm256_set1_ps(-FLT_MAX), vma = _mm256_setzero_ps();
+        for (int i = 0; i < WINDOW_LEN; i++) {
+            __m256 v = stride == 1 ? _mm256_loadu_ps(p + i) : _mm256_i32gather_ps(p + i, gatherIdx, 4);
+            vsum = _mm256_add_ps(vsum, v); vmin = _mm256_min_ps(v, vmin); vmax = _mm256_max_ps(v, vmax);
+            if (i >= WINDOW_LEN - MA_WINDOW) vma = _mm256_add_ps(vma, v);
+        }
+        _mm256_storeu_ps(s, vsum); _mm256_storeu_ps(mn, vmin); _mm256_storeu_ps(mx, vmax); _mm256_storeu_ps(ma, vma);
+        for (int k = 0; k < 8; k++) storeColumn(out + k * MODEL_INPUT_COUNT, c, s[k], mn[k], mx[k], ma[k]);
+    }
+}
+
+__attribute__((target("avx2")))
+static int quantizeAvx2(const float *in, int n, float scale, int32_t zero_point, int8_t *out) {
+    __m256 vscale = _mm256_set1_ps(scale), vzp = _mm256_set1_ps((float)zero_point), hi = _mm256_set1_ps(127), lo = _mm256_set1_ps(-128);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 q = _mm256_add_ps(_mm256_div_ps(_mm256_loadu_ps(in + i), vscale), vzp);
+        q = _mm256_max_ps(lo, _mm256_min_ps(hi, q));
+        __m256i ti = _mm256_cvttps_epi32(q); __m256 frac = _mm256_sub_ps(q, _mm256_cvtepi32_ps(ti));
+        ti = _mm256_sub_epi32(ti, _mm256_castps_si256(_mm256_cmp_ps(frac, _mm256_set1_ps(0.5f), _CMP_GE_OQ)));
+        ti = _mm256_add_epi32(ti, _mm256_castps_si256(_mm256_cmp_ps(frac, _mm256_set1_ps(-0.5f), _CMP_LE_OQ)));
+        __m128i t16 = _mm_packs_epi32(_mm256_castsi256_si128(ti), _mm256_extracti128_si256(ti, 1));
+        _mm_storel_epi64((__m128i*)(out + i), _mm_packs_epi16(t16, t16));
+    }
+    return i;
+}
+#endif
+
+// ============================================================================
+//  NEON (Pi 4): 4 windows per pass. 32-bit ARM NEON flushes denormals to zero,
+//  irrelevant for sensor values. Quantize needs vdivq_f32 (AArch64 only).
+// ============================================================================
+
+#ifdef HAVE_NEON
+static inline float32x4_t loadLanesNeon(const float *p, int stride) {
+    if (stride == 1) return vld1q_f32(p);
+    float32x4_t v = vdupq_n_f32(p[0]); v = vsetq_lane_f32(p[stride], v, 1); v = vsetq_lane_f32(p[2 * stride], v, 2); return vsetq_lane_f32(p[3 * stride], v, 3);
+}
+
+static void windowsNeon(const float *const cols[], int start, int stride, float *out) {
+    float s[4], mn[4], mx[4], ma[4];
+    for (int c = 0; c < RAW_FEATURE_COUNT; c++) {
+        const float *p = cols[c] + start;
+        float32x4_t vsum = vdupq_n_f32(0.0f), vmin = vdupq_n_f32(FLT_MAX), vmax = vdupq_n_f32(-FLT_MAX), vma = vdupq_n_f32(0.0f);
+        for (int i = 0; i < WINDOW_LEN; i++) {
+            float32x4_t v = loadLanesNeon(p + i, stride);
+            vsum = vaddq_f32(vsum, v); vmin = vbslq_f32(vcltq_f32(v, vmin), v, vmin); vmax = vbslq_f32(vcgtq_f32(v, vmax), v, vmax);
+            if (i >= WINDOW_LEN - MA_WINDOW) vma = vaddq_f32(vma, v);
+        }
+        vst1q_f32(s, vsum); vst1q_f32(mn, vmin); vst1q_f32(mx, vmax); vst1q_f32(ma, vma);
+        for (int k = 0; k < 4; k++) storeColumn(out + k * MODEL_INPUT_COUNT, c, s[k], mn[k], mx[k], ma[k]);
+    }
+}
+
+#if defined(__aarch64__)
+static int quantizeNeon(const float *in, int n, float scale, int32_t zero_point, int8_t *out) {
+    float32x4_t vscale = vdupq_n_f32(scale), vzp = vdupq_n_f32((float)zero_point), hi = vdupq_n_f32(127), lo = vdupq_n_f32(-128);
+    int32_t t[4]; int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t q = vaddq_f32(vdivq_f32(vld1q_f32(in + i), vscale), vzp);
+        q = vbslq_f32(vcgtq_f32(q, hi), hi, q); q = vbslq_f32(vcltq_f32(q, lo), lo, q);
+        int32x4_t ti = vcvtq_s32_f32(q); float32x4_t frac = vsubq_f32(q, vcvtq_f32_s32(ti));
+        ti = vsubq_s32(ti, vreinterpretq_s32_u32(vcgeq_f32(frac, vdupq_n_f32(0.5f))));
+        ti = vaddq_s32(ti, vreinterpretq_s32_u32(vcleq_f32(frac, vdupq_n_f32(-0.5f))));
+        vst1q_s32(t, ti);
+        for (int k = 0; k < 4; k++) out[i + k] = (int8_t)t[k];
+    }
+    return i;
+}
+#endif
+#endif
+
+// ============================================================================
+//  DISPATCH
+// ============================================================================
+
+bool featureIsaSupported(FeatureIsa isa) {
+    switch (isa) {
+    case ISA_SCALAR: return true;
+#ifdef HAVE_X86_SIMD
+    case ISA_SSE2: return true;
+    case ISA_AVX2: return __builtin_cpu_supports("avx2");
+#endif
+#ifdef HAVE_NEON
+#if defined(__aarch64__)
+    case ISA_NEON: return true;
+#else
+    case ISA_NEON: return (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+#endif
+#endif
+    default: return false;
+    }
+}
+
+const char *featureIsaName(FeatureIsa isa) { return ISA_NAMES[isa]; }
+
+static FeatureIsa detectIsa() {
+    const char *forced = getenv("FEATURES_ISA");
+    if (forced) for (int i = ISA_SCALAR; i <= ISA_NEON; i++) if (strcmp(forced, ISA_NAMES[i]) == 0 && featureIsaSupported((FeatureIsa)i)) return (FeatureIsa)i;
+    if (featureIsaSupported(ISA_AVX2)) return ISA_AVX2;
+    if (featureIsaSupported(ISA_SSE2)) return ISA_SSE2;
+    if (featureIsaSupported(ISA_NEON)) return ISA_NEON;
+    return ISA_SCALAR;
+}
+
+static FeatureIsa &currentIsa() { static FeatureIsa isa = detectIsa(); return isa; }
+
+FeatureIsa featureIsa() { return currentIsa(); }
+
+bool setFeatureIsa(FeatureIsa isa) {
+    if (!featureIsaSupported(isa)) return false;
+    currentIsa() = isa; return true;
+}
+
+void extractFeaturesBatch(const float *const cols[RAW_FEATURE_COUNT], int windowCount, int stride, float *out) {
+    int w = 0; FeatureIsa isa = currentIsa();
+#ifdef HAVE_X86_SIMD
+    if (isa == ISA_AVX2) for (; w + 8 <= windowCount; w += 8) windowsAvx2(cols, w * stride, stride, out + w * MODEL_INPUT_COUNT);
+    if (isa == ISA_AVX2 || isa == ISA_SSE2) for (; w + 4 <= windowCount; w += 4) windowsSse2(cols, w * stride, stride, out + w * MODEL_INPUT_COUNT);
+#endif
+#ifdef HAVE_NEON
+    if (isa == ISA_NEON) for (; w + 4 <= windowCount; w += 4) windowsNeon(cols, w * stride, stride, out + w * MODEL_INPUT_COUNT);
+#endif
+    for (; w < windowCount; w++) windowScalar(cols, w * stride, out + w * MODEL_INPUT_COUNT);
+}
+
+void quantizeInt8(const float *in, int n, float scale, int32_t zero_point, int8_t *out) {
+    int i = 0; FeatureIsa isa = currentIsa();
+#ifdef HAVE_X86_SIMD
+    if (isa == ISA_AVX2) i = quantizeAvx2(in, n, scale, zero_point, out);
+    if (isa == ISA_AVX2 || isa == ISA_SSE2) i += quantizeSse2(in + i, n - i, scale, zero_point, out + i);
+#endif
+#if defined(HAVE_NEON) && defined(__aarch64__)
+    if (isa == ISA_NEON) i = quantizeNeon(in, n, scale, zero_point, out);
+#endif
+    for (; i < n; i++) out[i] = quantizeOne(in[i], scale, zero_point);
+}
@@ -0,0 +1,32 @@
+#ifndef FEATUREKERNELS_H
+#define FEATUREKERNELS_H
+
+#include <stdint.h>
+
+// Model window: 5 raw columns (min_sin, min_cos, temp, humid, lux) over 90 samples,
+// reduced to avg/min/max/MA6 per column -> 20 model inputs
+#define RAW_FEATURE_COUNT 5
+#define MODEL_INPUT_COUNT 20
+#define WINDOW_LEN 90
+#define MA_WINDOW 6
+
+enum FeatureIsa { ISA_SCALAR = 0, ISA_SSE2, ISA_AVX2, ISA_NEON };
+
+// Batch feature extraction over a column-major series (cols[c][row], oldest row first).
+// Window w covers rows [w * stride, w * stride + WINDOW_LEN) and writes
+// out[w * MODEL_INPUT_COUNT + c * 4 + {avg, min, max, ma6}].
+// The SIMD paths put one window per lane and keep the scalar accumulation
+// order, so every path gives bit-identical results (same as ZonePipeline::computeFeatures).
+// Best ISA is picked at runtime; FEATURES_ISA=scalar|sse2|avx2|neon forces one.
+void extractFeaturesBatch(const float *const cols[RAW_FEATURE_COUNT], int windowCount, int stride, float *out);
+
+// int8 input quantization, q = clamp(round(x / scale + zeroPoint), -128, 127)
+void quantizeInt8(const float *in, int n, float scale, int32_t zeroPoint, int8_t *out);
+
+FeatureIsa featureIsa();
+bool featureIsaSupported(FeatureIsa isa);
+const char *featureIsaName(FeatureIsa isa);
+// Benchmark / verification hook: 0 if the ISA is not available here
+bool setFeatureIsa(FeatureIsa isa);
+
+#endif // FEATUREKERNELS_H
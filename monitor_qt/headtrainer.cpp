@@ -0,0 +1,301 @@
+#include "headtrainer.h"
+#include "historystore.h"
+#include "logcompactor.h"
+#include "opresolver.h"
+#include "virtualclock.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSet>
+#include <QJsonArray>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/schema/schema_utils.h"
+
+HeadTrainer::HeadTrainer(const QString &modelPath, const TrainingConfig &cfg) : modelPath(modelPath), cfg(cfg) {}
+
+// ---------------------------------------------------------------- training windows
+
+void HeadTrainer::addSeries(const QVector<float> *cols, const QVector<int> &rowLabels) {
+    int rows = rowLabels.size(); if (rows < WINDOW_LEN) return;
+    int count = rows - WINDOW_LEN + 1;
+    QVector<float> all(count * MODEL_INPUT_COUNT);
+    const float *colPtr[RAW_FEATURE_COUNT]; for (int c = 0; c < RAW_FEATURE_COUNT; c++) colPtr[c] = cols[c].constData();
+    extractFeaturesBatch(colPtr, count, 1, all.data());
+    for (int w = 0; w < count; w++) {
+        // Same target as the live labeling: the label of the window's last sample
+        int label = rowLabels[w + WINDOW_LEN - 1];
+        if (label == 0 && w % cfg.stride != 0) continue;
+        for (int i = 0; i < MODEL_INPUT_COUNT; i++) features.append(all[w * MODEL_INPUT_COUNT + i]);
+        labels.append(label); heldOut.append(false);
+    }
+}
+
+void HeadTrainer::addZone(const QString &dataDir, const QList<BufferedSample> &recent) {
+    int firstWindow = labels.size();
+    QVector<float> cols[RAW_FEATURE_COUNT]; QVector<int> rowLabels; qint64 lastMs = 0;
+    auto append = [&](qint64 ms, const float *raw, int label) {
+        if (lastMs && ms - lastMs > TRAIN_MAX_GAP_S * 1000) { addSeries(cols, rowLabels); for (QVector<float> &c : cols) c.clear(); rowLabels.clear(); }
+        for (int c = 0; c < RAW_FEATURE_COUNT; c++) cols[c].append(raw[c]);
+        rowLabels.append(label); lastMs = ms;
+    };
+
+    // Day files, plain or compressed (both may exist while the compactor runs)
+    QSet<QString> days;
+    for (const QString &name : QDir(dataDir).entryList(LogCompactor::dayFileFilters(), QDir::Files, QDir::Name)) days.insert(name.left(10));
+    QStringList dayList = days.values(); std::sort(dayList.begin(), dayList.end());
+    for (const QString &day : dayList) {
+        QByteArray data = LogCompactor::readDayFile(LogCompactor::dayFilePath(dataDir, day));
+        for (const QByteArray &line : data.split('\n')) {
+            // timestamp_ms,min_sin,min_cos,temp,humid,lux,label (label may contain ", ")
+            QList<QByteArray> parts = line.split(',');
+            if (parts.size() < 7) continue;
+            bool ok; qint64 ms = parts[0].toLongLong(&ok); if (!ok) continue; // header
+            float raw[RAW_FEATURE_COUNT]; for (int c = 0; c < RAW_FEATURE_COUNT; c++) raw[c] = parts[c + 1].toFloat();
+            append(ms, raw, HistoryStore::labelIndex(QString::fromLatin1(line).section(',', 6).trimmed()));
+        }
+    }
+
+    // Unflushed samples. An event seen on the next tick relabels back to the newest sample minus
+    // DETECTION_WINDOW + PREDICTION_OFFSET: only the samples before that have their final label
+    int settled = recent.size() - DETECTION_WINDOW - PREDICTION_OFFSET;
+    for (int i = 0; i < settled; i++) {
+        const BufferedSample &s = recent[i];
+        float raw[RAW_FEATURE_COUNT] = {s.features[0], s.features[1], s.temp, s.humid, s.lux};
+        append((qint64)s.timestamp * 1000, raw, HistoryStore::labelIndex(s.label));
+    }
+    addSeries(cols, rowLabels);
+
+    // Chronological split: the most recent part of the zone validates what the older part taught
+    int zoneWindows = labels.size() - firstWindow, validation = (int)(zoneWindows * cfg.validation);
+    for (int w = labels.size() - validation; w < labels.size(); w++) heldOut[w] = true;
+    for (int w = firstWindow; w < labels.size(); w++) if (!heldOut[w]) classWindows[labels[w]]++;
+}
+
+double HeadTrainer::balancedAccuracy(const QVector<int> &predicted) const {
+    // Mean per-class recall over the held-out windows, so "normal" cannot dominate
+    int seen[NUM_LABELS] = {0}, hit[NUM_LABELS] = {0}, p = 0;
+    for (int w = 0; w < labels.size(); w++) {
+        if (!heldOut[w]) continue;
+        seen[labels[w]]++; if (predicted[p++] == labels[w]) hit[labels[w]]++;
+    }
+    double sum = 0; int classes = 0;
+    for (int c = 0; c < NUM_LABELS; c++) if (seen[c] > 0) { sum += (double)hit[c] / seen[c]; classes++; }
+    return classes > 0 ? sum / classes : 0;
+}
+
+// ---------------------------------------------------------------- model access
+
+// Runs windows (indices into features) one at a time through a model; collects the
+// predicted label and, if headInput >= 0, the dequantized values of that tensor
+static bool runWindows(const QString &path, const QVector<float> &features, const QVector<int> &windows, int headInput,
+                       QVector<float> *hidden, QVector<int> *predicted, QString *error) {
+    auto model = tflite::FlatBufferModel::BuildFromFile(path.toLocal8Bit().constData());
+    if (!model) { *error = "cannot read " + path; return false; }
+    QString resolverInfo; std::unique_ptr<tflite::OpResolver> resolver = TrimmedOpResolver::create(path, *model, &resolverInfo);
+    tflite::InterpreterOptions options; options.SetPreserveAllTensors(true);
+    std::unique_ptr<tflite::Interpreter> interpreter; tflite::InterpreterBuilder builder(*model, *resolver, &options); builder(&interpreter);
+    if (!interpreter || interpreter->AllocateTensors() != kTfLiteOk) { *error = "cannot build interpreter (" + resolverInfo + ")"; return false; }
+
+    TfLiteTensor *input = interpreter->tensor(interpreter->inputs()[0]), *output = interpreter->tensor(interpreter->outputs()[0]);
+    const TfLiteTensor *head = headInput >= 0 ? interpreter->tensor(headInput) : nullptr;
+    int headSize = head ? head->bytes / (head->type == kTfLiteInt8 ? 1 : sizeof(float)) : 0;
+    for (int w : windows) {
+        const float *in = features.constData() + w * MODEL_INPUT_COUNT;
+        if (input->type == kTfLiteInt8) quantizeInt8(in, MODEL_INPUT_COUNT, input->params.scale, input->params.zero_point, interpreter->typed_input_tensor<int8_t>(0));
+        else { float *input_data = interpreter->typed_input_tensor<float>(0); for (int i = 0; i < MODEL_INPUT_COUNT; i++) input_data[i] = in[i]; }
+        if (interpreter->Invoke() != kTfLiteOk) { *error = "Invoke() failed"; return false; }
+
+        float probs[NUM_LABELS];
+        if (output->type == kTfLiteInt8) { int8_t *out_data = interpreter->typed_output_tensor<int8_t>(0); for (int i = 0; i < NUM_LABELS; i++) probs[i] = (out_data[i] - output->params.zero_point) * output->params.scale; }
+        else { float *out_data = interpreter->typed_output_tensor<float>(0); for (int i = 0; i < NUM_LABELS; i++) probs[i] = out_data[i]; }
+        int max_idx = 0; for (int i = 1; i < NUM_LABELS; i++) if (probs[i] > probs[max_idx]) max_idx = i;
+        predicted->append(max_idx);
+
+        if (head && head->type == kTfLiteInt8) { const int8_t *h = head->data.int8; for (int i = 0; i < headSize; i++) hidden->append((h[i] - head->params.zero_point) * head->params.scale); }
+        else if (head) { const float *h = head->data.f; for (int i = 0; i < headSize; i++) hidden->append(h[i]); }
+    }
+    return true;
+}
+
+// Head = FULLY_CONNECTED (no fused activation) with NUM_LABELS outputs feeding the SOFTMAX
+static const tflite::Operator *findHead(const tflite::Model *model, QString *error) {
+    const tflite::SubGraph *graph = model->subgraphs() && model->subgraphs()->size() > 0 ? model->subgraphs()->Get(0) : nullptr;
+    if (!graph || !graph->operators()) { *error = "model has no graph"; return nullptr; }
+    const auto *codes = model->operator_codes(); const tflite::Operator *head = nullptr;
+    for (const tflite::Operator *op : *graph->operators()) {
+        if (tflite::GetBuiltinCode(codes->Get(op->opcode_index())) != tflite::BuiltinOperator_SOFTMAX) continue;
+        int logits = op->inputs()->Get(0);
+        for (const tflite::Operator *fc : *graph->operators())
+            if (tflite::GetBuiltinCode(codes->Get(fc->opcode_index())) == tflite::BuiltinOperator_FULLY_CONNECTED && fc->outputs()->Get(0) == logits) head = fc;
+    }
+    if (!head) { *error = "no FULLY_CONNECTED -> SOFTMAX head"; return nullptr; }
+    const tflite::FullyConnectedOptions *opts = head->builtin_options_as_FullyConnectedOptions();
+    if (opts && opts->fused_activation_function() != tflite::ActivationFunctionType_NONE) { *error = "head has a fused activation"; return nullptr; }
+    if (head->inputs()->size() < 3 || head->inputs()->Get(2) < 0) { *error = "head has no bias"; return nullptr; }
+    const tflite::Tensor *weights = graph->tensors()->Get(head->inputs()->Get(1));
+    if (weights->shape()->size() != 2 || weights->shape()->Get(0) != NUM_LABELS) { *error = "head is not " + QString::number(NUM_LABELS) + " outputs"; return nullptr; }
+    return head;
+}
+
+// Constant data of a tensor inside the (writable) model bytes
+static char *tensorData(const tflite::Model *model, const tflite::Tensor *tensor, int *size) {
+    const tflite::Buffer *buffer = model->buffers()->Get(tensor->buffer());
+    if (!buffer || !buffer->data()) { *size = 0; return nullptr; }
+    *size = buffer->data()->size(); return (char *)buffer->data()->data();
+}
+
+static float quantScale(const tflite::Tensor *tensor, int channel) {
+    const tflite::QuantizationParameters *q = tensor->quantization();
+    if (!q || !q->scale() || q->scale()->size() == 0) return 1.0f;
+    return q->scale()->Get(q->scale()->size() > 1 ? channel : 0);
+}
+
+// ---------------------------------------------------------------- training
+
+bool HeadTrainer::train(const QString &outPath) {
+    QElapsedTimer timer; timer.start();
+    result = QJsonObject{{"model", modelPath}, {"started", (qint64)VirtualClock::now()}, {"passed", false}};
+    auto fail = [&](const QString &why) { error = why; result["reason"] = why; return false; };
+
+    int total = labels.size();
+    QVector<int> trainSet, validSet;
+    for (int w = 0; w < total; w++) (heldOut[w] ? validSet : trainSet).append(w);
+    result["train_windows"] = trainSet.size(); result["validation_windows"] = validSet.size();
+    QJsonArray perClass; for (int c = 0; c < NUM_LABELS; c++) perClass.append(classWindows[c]); result["class_windows"] = perClass;
+    for (int c = 1; c < NUM_LABELS; c++)
+        if (classWindows[c] < cfg.minClassWindows) return fail(QString("only %1 training windows of %2 (need %3)").arg(classWindows[c]).arg(LABELS_TEXT[c]).arg(cfg.minClassWindows));
+    if (validSet.isEmpty()) return fail("no validation windows");
+
+    // Writable copy of the model; only bytes inside existing buffers are changed
+    QFile in(modelPath); if (!in.open(QIODevice::ReadOnly)) return fail("cannot read " + modelPath);
+    QByteArray bytes = in.readAll(); in.close();
+    flatbuffers::Verifier verifier((const uint8_t *)bytes.constData(), bytes.size());
+    if (!tflite::VerifyModelBuffer(verifier)) return fail("model file does not verify");
+    const tflite::Model *model = tflite::GetModel(bytes.data());
+    const tflite::Operator *head = findHead(model, &error); if (!head) return fail(error);
+    const tflite::SubGraph *graph = model->subgraphs()->Get(0);
+    int headInput = head->inputs()->Get(0);
+    const tflite::Tensor *inT = graph->tensors()->Get(headInput), *wT = graph->tensors()->Get(head->inputs()->Get(1));
+    const tflite::Tensor *bT = graph->tensors()->Get(head->inputs()->Get(2)), *outT = graph->tensors()->Get(head->outputs()->Get(0));
+    int dim = wT->shape()->Get(1);
+    bool quantized = wT->type() == tflite::TensorType_INT8;
+    if (!quantized && wT->type() != tflite::TensorType_FLOAT32) return fail("unsupported head weight type");
+    if (bT->type() != (quantized ? tflite::TensorType_INT32 : tflite::TensorType_FLOAT32)) return fail("unsupported head bias type (hybrid model?)");
+    int wBytes, bBytes; char *wData = tensorData(model, wT, &wBytes), *bData = tensorData(model, bT, &bBytes);
+    if (!wData || wBytes != NUM_LABELS * dim * (quantized ? 1 : 4) || !bData || bBytes != NUM_LABELS * 4) return fail("head weights are not constant buffers");
+
+    // 1. Frozen layers once: head inputs of every window + what the deployed model predicts
+    QVector<int> all; for (int w = 0; w < total; w++) all.append(w);
+    QVector<float> H; QVector<int> oldPredicted;
+    if (!runWindows(modelPath, features, all, headInput, &H, &oldPredicted, &error)) return fail(error);
+    if (H.size() != total * dim) return fail("head input is not " + QString::number(dim) + " values");
+    QVector<int> oldValid; for (int w : validSet) oldValid.append(oldPredicted[w]);
+    double oldAccuracy = balancedAccuracy(oldValid);
+
+    // 2. Deployed head in float
+    QVector<float> W(NUM_LABELS * dim), b(NUM_LABELS);
+    float inScale = inT->quantization() && inT->quantization()->scale() && inT->quantization()->scale()->size() > 0 ? inT->quantization()->scale()->Get(0) : 1.0f;
+    for (int c = 0; c < NUM_LABELS; c++) {
+        for (int i = 0; i < dim; i++) W[c * dim + i] = quantized ? ((int8_t *)wData)[c * dim + i] * quantScale(wT, c) : ((float *)wData)[c * dim + i];
+        b[c] = quantized ? ((int32_t *)bData)[c] * inScale * quantScale(wT, c) : ((float *)bData)[c];
+    }
+
+    // 3. Standardize the head inputs (training set statistics), fold into the weights: z = W'x' + b'
+    QVector<float> mean(dim, 0.0f), stdev(dim, 0.0f);
+    for (int w : trainSet) for (int i = 0; i < dim; i++) mean[i] += H[w * dim + i] / trainSet.size();
+    for (int w : trainSet) for (int i = 0; i < dim; i++) { float d = H[w * dim + i] - mean[i]; stdev[i] += d * d / trainSet.size(); }
+    for (int i = 0; i < dim; i++) stdev[i] = stdev[i] > 1e-12f ? sqrtf(stdev[i]) : 1.0f;
+    QVector<float> Ws(NUM_LABELS * dim), bs(b);
+    for (int c = 0; c < NUM_LABELS; c++) for (int i = 0; i < dim; i++) { Ws[c * dim + i] = W[c * dim + i] * stdev[i]; bs[c] += W[c * dim + i] * mean[i]; }
+    QVector<float> W0(Ws), vW(Ws.size(), 0.0f), vb(NUM_LABELS, 0.0f);
+
+    // Inverse frequency class weights
+    float classWeight[NUM_LABELS];
+    for (int c = 0; c < NUM_LABELS; c++) classWeight[c] = classWindows[c] > 0 ? (float)trainSet.size() / (NUM_LABELS * classWindows[c]) : 0.0f;
+
+    // 4. Mini-batch SGD with momentum, learning rate decayed linearly to 0
+    unsigned seed = 1; QVector<int> order(trainSet);
+    QVector<float> gW(Ws.size()), x(dim); float gb[NUM_LABELS];
+    for (int epoch = 0; epoch < cfg.epochs; epoch++) {
+        float lr = cfg.learningRate * (1.0f - (float)epoch / cfg.epochs);
+        for (int i = order.size() - 1; i > 0; i--) std::swap(order[i], order[rand_r(&seed) % (i + 1)]);
+        for (int start = 0; start < order.size(); start += TRAIN_BATCH) {
+            int end = qMin(order.size(), start + TRAIN_BATCH); float weightSum = 0;
+            gW.fill(0.0f); for (float &g : gb) g = 0;
+            for (int k = start; k < end; k++) {
+                int w = order[k]; float z[NUM_LABELS], zmax = -1e30f, sum = 0;
+                for (int i = 0; i < dim; i++) x[i] = (H[w * dim + i] - mean[i]) / stdev[i];
+                for (int c = 0; c < NUM_LABELS; c++) { z[c] = bs[c]; for (int i = 0; i < dim; i++) z[c] += Ws[c * dim + i] * x[i]; zmax = qMax(zmax, z[c]); }
+                for (int c = 0; c < NUM_LABELS; c++) { z[c] = expf(z[c] - zmax); sum += z[c]; }
+                float cw = classWeight[labels[w]]; weightSum += cw;
+                for (int c = 0; c < NUM_LABELS; c++) {
+                    float g = cw * (z[c] / sum - (c == labels[w] ? 1.0f : 0.0f));
+                    gb[c] += g; for (int i = 0; i < dim; i++) gW[c * dim + i] += g * x[i];
+                }
+            }
+            if (weightSum <= 0) continue;
+            for (int j = 0; j < Ws.size(); j++) { vW[j] = TRAIN_MOMENTUM * vW[j] - lr * (gW[j] / weightSum + TRAIN_L2 * (Ws[j] - W0[j])); Ws[j] += vW[j]; }
+            for (int c = 0; c < NUM_LABELS; c++) { vb[c] = TRAIN_MOMENTUM * vb[c] - lr * gb[c] / weightSum; bs[c] += vb[c]; }
+        }
+    }
+
+    // Back to the raw head input: W = W'/std, b = b' - sum(W * mean)
+    QVector<float> newW(Ws.size()), newB(bs);
+    for (int c = 0; c < NUM_LABELS; c++) for (int i = 0; i < dim; i++) { newW[c * dim + i] = Ws[c * dim + i] / stdev[i]; newB[c] -= newW[c * dim + i] * mean[i]; }
+
+    // 5. Patch the copy. int8: symmetric weights (per channel if the model is), int32 bias at inScale * wScale,
+    // logits quantization from the range seen on the training windows
+    if (quantized) {
+        const tflite::QuantizationParameters *wq = wT->quantization(), *oq = outT->quantization();
+        if (!wq || !wq->scale() || !oq || !oq->scale() || oq->scale()->size() != 1 || !oq->zero_point()) return fail("head is not int8 quantized");
+        bool perChannel = wq->scale()->size() > 1;
+        float *wScales = (float *)wq->scale()->data();
+        float globalMax = 0; float channelMax[NUM_LABELS];
+        for (int c = 0; c < NUM_LABELS; c++) { channelMax[c] = 0; for (int i = 0; i < dim; i++) channelMax[c] = qMax(channelMax[c], fabsf(newW[c * dim + i])); globalMax = qMax(globalMax, channelMax[c]); }
+        for (int c = 0; c < NUM_LABELS; c++) {
+            float scale = qMax(perChannel ? channelMax[c] : globalMax, 1e-8f) / 127.0f;
+            if (perChannel || c == 0) wScales[perChannel ? c : 0] = scale;
+            for (int i = 0; i < dim; i++) ((int8_t *)wData)[c * dim + i] = (int8_t)qBound(-127, (int)lrintf(newW[c * dim + i] / scale), 127);
+            ((int32_t *)bData)[c] = (int32_t)lrintf(newB[c] / (inScale * scale));
+        }
+        if (bT->quantization() && bT->quantization()->scale()) {
+            float *bScales = (float *)bT->quantization()->scale()->data();
+            for (int c = 0; c < (int)bT->quantization()->scale()->size(); c++) bScales[c] = inScale * wScales[perChannel ? c : 0];
+        }
+        float zmin = 0, zmax = 0;
+        for (int w : trainSet) for (int c = 0; c < NUM_LABELS; c++) {
+            float z = newB[c]; for (int i = 0; i < dim; i++) z += newW[c * dim + i] * H[w * dim + i];
+            zmin = qMin(zmin, z); zmax = qMax(zmax, z);
+        }
+        float outScale = qMax(zmax - zmin, 1e-6f) / 255.0f;
+        ((float *)oq->scale()->data())[0] = outScale;
+        ((int64_t *)oq->zero_point()->data())[0] = qBound(-128, (int)lrintf(-128 - zmin / outScale), 127);
+    } else {
+        memcpy(wData, newW.constData(), wBytes); memcpy(bData, newB.constData(), bBytes);
+    }
+
+    QString tmp = outPath + ".tmp"; QFile out(tmp);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate) || out.write(bytes) != bytes.size()) return fail("cannot write " + tmp);
+    out.close(); QFile::remove(outPath);
+    if (!QFile::rename(tmp, outPath)) return fail("cannot rename " + tmp);
+
+    // 6. The candidate as it will run (quantized), on the held-out windows
+    QVector<float> unused; QVector<int> newValid;
+    if (!runWindows(outPath, features, validSet, -1, &unused, &newValid, &error)) { QFile::remove(outPath); QFile::remove(TrimmedOpResolver::opListPath(outPath)); return fail(error); }
+    double newAccuracy = balancedAccuracy(newValid);
+    result["old_balanced_accuracy"] = oldAccuracy; result["new_balanced_accuracy"] = newAccuracy;
+    result["train_ms"] = (qint64)timer.elapsed(); result["finished"] = (qint64)VirtualClock::now();
+    if (newAccuracy < oldAccuracy - TRAIN_MAX_DROP) {
+        QFile::remove(outPath); QFile::remove(TrimmedOpResolver::opListPath(outPath));
+        return fail(QString("balanced accuracy %1% vs deployed %2%").arg(newAccuracy * 100, 0, 'f', 1).arg(oldAccuracy * 100, 0, 'f', 1));
+    }
+    result["passed"] = true; result["reason"] = QString("balanced accuracy %1% (deployed %2%)").arg(newAccuracy * 100, 0, 'f', 1).arg(oldAccuracy * 100, 0, 'f', 1);
+    return true;
+}
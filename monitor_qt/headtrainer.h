@@ -0,0 +1,57 @@
+#ifndef HEADTRAINER_H
+#define HEADTRAINER_H
+
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QJsonObject>
+
+#include "zonepipeline.h"
+#include "monitorcore.h"   // NUM_LABELS
+
+#define TRAIN_MAX_GAP_S   30      // a longer hole in the log starts a new series (no window across it)
+#define TRAIN_BATCH       64
+#define TRAIN_MOMENTUM    0.9f
+#define TRAIN_L2          1e-3f   // pull toward the deployed head, so few events cannot wreck it
+#define TRAIN_MAX_DROP    0.02    // reject if validation balanced accuracy drops more than this
+
+// On-device fine-tuning of the classifier head (last FULLY_CONNECTED before the
+// softmax) of the deployed model. Windows come from each zone's CSV history
+// followed by the part of its unflushed dataBuffer that no event can relabel any
+// more, labeled with the label of their last sample; event windows are all kept, normal ones every TrainingConfig::stride
+// samples. The frozen layers run once through TFLite to get the head inputs, the
+// head is refit with class-weighted softmax regression, then re-quantized to int8
+// and patched into a copy of the model file (same layout, only weights, bias and
+// the head's quantization parameters change).
+class HeadTrainer
+{
+public:
+    HeadTrainer(const QString &modelPath, const TrainingConfig &cfg);
+
+    // The last TrainingConfig::validation part of each zone is held out
+    void addZone(const QString &dataDir, const QList<BufferedSample> &recent);
+    int windowCount(int label) const { return classWindows[label]; }
+
+    // Writes the candidate to outPath; false (with error()) if there is not enough
+    // labeled data, the model has no usable head or the result is worse
+    bool train(const QString &outPath);
+    QString errorString() const { return error; }
+    QJsonObject report() const { return result; }
+
+private:
+    QString modelPath;
+    TrainingConfig cfg;
+    QString error;
+    QJsonObject result;
+
+    // MODEL_INPUT_COUNT features per window
+    QVector<float> features;
+    QVector<int> labels;
+    QVector<bool> heldOut;
+    int classWindows[NUM_LABELS] = {0};
+
+    void addSeries(const QVector<float> *cols, const QVector<int> &rowLabels);
+    double balancedAccuracy(const QVector<int> &predicted) const;
+};
+
+#endif // HEADTRAINER_H
@@ -0,0 +1,109 @@
+#include "historystore.h"
+#include "logcompactor.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <algorithm>
+
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+
+HistoryStore::HistoryStore(const QStringList &zoneDirs, int cacheDays) : zoneDirs(zoneDirs), dayIndex(zoneDirs.size())
+{
+    cache.setMaxCost(cacheDays);
+}
+
+int HistoryStore::labelIndex(const QString &label) {
+    if (label == "temp_inc, humid_dec") return 1;
+    if (label == "temp_inc, humid_inc") return 2;
+    return 0;
+}
+
+// Day files of a zone (plain or compressed), sorted (yyyy-MM-dd sorts like the date)
+QStringList HistoryStore::days(int zone) {
+    QFileInfo dirInfo(zoneDirs[zone]); qint64 mtime = dirInfo.lastModified().toMSecsSinceEpoch();
+    QMutexLocker lock(&cacheMutex);
+    DayIndex &idx = dayIndex[zone];
+    if (idx.mtime != mtime) {
+        QDir dir(zoneDirs[zone]); dir.setNameFilters(LogCompactor::dayFileFilters()); dir.setSorting(QDir::Name);
+        // A day may briefly exist in both forms while it is being compressed
+        idx.days.clear(); for (const QString &f : dir.entryList(QDir::Files)) if (idx.days.isEmpty() || idx.days.last() != f.left(10)) idx.days.append(f.left(10));
+        idx.mtime = mtime;
+    }
+    return idx.days;
+}
+
+QSharedPointer<const DaySegment> HistoryStore::segment(const QString &path) {
+    QFileInfo fi(path); if (!fi.exists()) return QSharedPointer<const DaySegment>();
+    qint64 size = fi.size(); qint64 mtime = fi.lastModified().toMSecsSinceEpoch();
+    QSharedPointer<const DaySegment> old;
+    {
+        QMutexLocker lock(&cacheMutex);
+        CacheEntry *e = cache.object(path);
+        if (e && e->fileSize == size && e->mtime == mtime) return e->seg;
+        if (e && size >= e->seg->parsedBytes) old = e->seg;   // today's file grew: decode only the new rows
+    }
+    // Decode outside the lock so slow reads do not block other queries
+    QSharedPointer<DaySegment> seg(old ? new DaySegment(*old) : new DaySegment);
+    decode(path, seg.data());
+    QMutexLocker lock(&cacheMutex);
+    cache.insert(path, new CacheEntry{seg, size, mtime}, 1);
+    return seg;
+}
+
+// Row format: timestamp_ms,min_sin,min_cos,temp,humid,lux,label (label may contain ", ")
+void HistoryStore::decode(const QString &path, DaySegment *seg) {
+    QByteArray data;
+    if (path.endsWith(COMPRESSED_SUFFIX)) data = LogCompactor::readDayFile(path).mid(seg->parsedBytes);   // finished day, never grows
+    else { QFile f(path); if (!f.open(QIODevice::ReadOnly) || !f.seek(seg->parsedBytes)) return; data = f.readAll(); }
+    int end = data.lastIndexOf('\n'); if (end < 0) return;   // keep a partly written line for next time
+    data.truncate(end + 1);
+
+    char *line = data.data(); char *stop = line + data.size();
+    while (line < stop) {
+        char *nl = (char*)memchr(line, '\n', stop - line); *nl = 0;
+        char *p = line, *q;
+        long long ms = strtoll(p, &q, 10);
+        if (q != p && *q == ',') {
+            p = strchr(q + 1, ','); if (p) p = strchr(p + 1, ',');
+            float v[HISTORY_FIELDS]; bool ok = p != NULL;
+            for (int i = 0; ok && i < HISTORY_FIELDS; i++) { v[i] = strtof(p + 1, &q); ok = (q != p + 1 && *q == ','); p = q; }
+            if (ok) {
+                seg->ts.append(ms / 1000);
+                for (int i = 0; i < HISTORY_FIELDS; i++) seg->value[i].append(v[i]);
+                seg->label.append((qint8)labelIndex(QString::fromLatin1(p + 1).trimmed()));
+            }
+        }
+        line = nl + 1;
+    }
+    seg->parsedBytes += end + 1;
+}
+
+void HistoryStore::scan(int zone, qint64 from, qint64 to, const std::function<bool(const DaySegment &, int)> &fn) {
+    if (zone < 0 || zone >= zoneDirs.size() || from > to) return;
+    // Local dates, like the file names written by the logger
+    QString firstDay = QDateTime::fromSecsSinceEpoch(from).date().toString("yyyy-MM-dd");
+    QString lastDay = QDateTime::fromSecsSinceEpoch(to).date().toString("yyyy-MM-dd");
+    QStringList all = days(zone);
+    for (auto it = std::lower_bound(all.begin(), all.end(), firstDay); it != all.end() && *it <= lastDay; ++it) {
+        QSharedPointer<const DaySegment> seg = segment(LogCompactor::dayFilePath(zoneDirs[zone], *it));
+        if (!seg) continue;
+        int row = std::lower_bound(seg->ts.begin(), seg->ts.end(), from) - seg->ts.begin();
+        for (; row < seg->ts.size() && seg->ts[row] <= to; row++) if (!fn(*seg, row)) return;
+    }
+}
+
+RangeStats HistoryStore::stats(int zone, qint64 from, qint64 to) {
+    RangeStats st;
+    for (int i = 0; i < HISTORY_FIELDS; i++) { st.min[i] = FLT_MAX; st.max[i] = -FLT_MAX; }
+    scan(zone, from, to, [&](const DaySegment &seg, int row) {
+        st.count++;
+        for (int i = 0; i < HISTORY_FIELDS; i++) { float v = seg.value[i][row]; if (v < st.min[i]) st.min[i] = v; if (v > st.max[i]) st.max[i] = v; st.sum[i] += v; }
+        st.labelCounts[seg.label[row]]++;
+        return true;
+    });
+    return st;
+}
@@ -0,0 +1,63 @@
+#ifndef HISTORYSTORE_H
+#define HISTORYSTORE_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QCache>
+#include <QMutex>
+#include <QSharedPointer>
+#include <functional>
+
+#define HISTORY_CACHE_DAYS 32
+#define HISTORY_FIELDS 3     // temp, humid, lux
+#define HISTORY_LABELS 3     // normal, temp_inc+humid_dec, temp_inc+humid_inc
+
+// One decoded yyyy-MM-dd.csv(.gz) file, columns stored separately for fast scans
+struct DaySegment {
+    qint64 parsedBytes = 0;       // file offset up to which rows are decoded
+    QVector<qint64> ts;           // unix seconds, ascending
+    QVector<float> value[HISTORY_FIELDS];
+    QVector<qint8> label;
+};
+
+struct RangeStats {
+    int count = 0;
+    float min[HISTORY_FIELDS];
+    float max[HISTORY_FIELDS];
+    double sum[HISTORY_FIELDS] = {0, 0, 0};
+    int labelCounts[HISTORY_LABELS] = {0, 0, 0};
+};
+
+// Read side of the CSV history written by ZonePipeline::record().
+// Files are located through the per-day naming (one file per zone and day),
+// decoded once into an LRU cache and re-read incrementally while today's file grows.
+// Thread-safe: queries run on worker threads next to the logging timer.
+class HistoryStore
+{
+public:
+    HistoryStore(const QStringList &zoneDirs, int cacheDays = HISTORY_CACHE_DAYS);
+
+    int zoneCount() const { return zoneDirs.size(); }
+    // Calls fn(segment, row) for every sample with from <= ts <= to, oldest first,
+    // until fn returns false (later days are then not loaded at all)
+    void scan(int zone, qint64 from, qint64 to, const std::function<bool(const DaySegment &, int)> &fn);
+    RangeStats stats(int zone, qint64 from, qint64 to);
+
+    static int labelIndex(const QString &label);
+
+private:
+    struct CacheEntry { QSharedPointer<const DaySegment> seg; qint64 fileSize; qint64 mtime; };
+    struct DayIndex { qint64 mtime = -1; QStringList days; };
+
+    QStringList zoneDirs;
+    QMutex cacheMutex;
+    QCache<QString, CacheEntry> cache;   // key: file path, LRU over decoded days
+    QVector<DayIndex> dayIndex;          // per zone, refreshed when the folder changes
+
+    QStringList days(int zone);
+    QSharedPointer<const DaySegment> segment(const QString &path);
+    static void decode(const QString &path, DaySegment *seg);
+};
+
+#endif // HISTORYSTORE_H
@@ -0,0 +1,161 @@
+#include "iiosensorsource.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Channels each sensor type needs, in SensorSample field order
+static QStringList channelNames(SensorKind kind) {
+    return kind == SENSOR_DHT11 ? QStringList() << "temp" << "humidityrelative" : QStringList() << "illuminance";
+}
+
+QByteArray IioSensorSource::readAttr(const QString &path) {
+    QFile file(path); if (!file.open(QIODevice::ReadOnly)) return QByteArray();
+    return file.readAll().trimmed();
+}
+
+bool IioSensorSource::writeAttr(const QString &path, const QByteArray &value) {
+    QFile file(path); if (!file.open(QIODevice::WriteOnly)) return false;
+    return file.write(value) == value.size();
+}
+
+QString IioSensorSource::findDevice(const QString &name, int ordinal) {
+    QDir sysfs(IIO_SYSFS_DIR);
+    QStringList devices = sysfs.entryList(QStringList() << "iio:device*", QDir::Dirs | QDir::System);
+    // iio:device10 after iio:device9
+    std::sort(devices.begin(), devices.end(), [](const QString &a, const QString &b) { return a.mid(10).toInt() < b.mid(10).toInt(); });
+    for (const QString &dev : devices) {
+        if (readAttr(sysfs.filePath(dev) + "/name") != name.toLatin1()) continue;
+        if (ordinal-- == 0) return sysfs.filePath(dev);
+    }
+    return QString();
+}
+
+IioSensorSource::IioSensorSource(const QString &spec, SensorKind kind, bool buffered) : buffered(buffered)
+{
+    // <name>[#n][@trigger]
+    QString name = spec.section('@', 0, 0), trigger = spec.section('@', 1);
+    int ordinal = name.contains('#') ? name.section('#', 1).toInt() : 0; name = name.section('#', 0, 0);
+    dir = findDevice(name, ordinal);
+    if (dir.isEmpty()) { error = QString("no IIO device '%1' #%2").arg(name).arg(ordinal); return; }
+
+    QStringList names = channelNames(kind);
+    for (int i = 0; i < names.size(); i++) {
+        Channel ch; ch.name = names[i]; ch.field = kind == SENSOR_DHT11 ? i : 2;
+        // Scale/offset: per channel or shared by the channel type (in_temp_scale)
+        QByteArray scale = readAttr(QString("%1/in_%2_scale").arg(dir, ch.name)), offset = readAttr(QString("%1/in_%2_offset").arg(dir, ch.name));
+        if (!scale.isEmpty()) ch.scale = scale.toDouble();
+        if (!offset.isEmpty()) ch.offset = offset.toDouble();
+        channels.append(ch);
+    }
+    valid = buffered ? setupBuffered(trigger) : setupDirect();
+}
+
+IioSensorSource::~IioSensorSource() {
+    for (Channel &ch : channels) if (ch.fd >= 0) ::close(ch.fd);
+    if (devFd >= 0) ::close(devFd);
+    if (bufferEnabled) {
+        writeAttr(dir + "/buffer/enable", "0");
+        for (const Channel &ch : channels) writeAttr(QString("%1/scan_elements/in_%2_en").arg(dir, ch.name), "0");
+    }
+}
+
+bool IioSensorSource::setupDirect() {
+    for (Channel &ch : channels) {
+        // Processed value if the driver has one (dht11), raw * scale otherwise (bh1750)
+        QString input = QString("%1/in_%2_input").arg(dir, ch.name), raw = QString("%1/in_%2_raw").arg(dir, ch.name);
+        ch.processed = QFileInfo::exists(input);
+        QByteArray path = (ch.processed ? input : raw).toLocal8Bit();
+        ch.fd = ::open(path.constData(), O_RDONLY);
+        if (ch.fd < 0) { error = QString("%1: %2").arg(QString(path), strerror(errno)); return false; }
+    }
+    return true;
+}
+
+bool IioSensorSource::setupBuffered(const QString &trigger) {
+    QString scanDir = dir + "/scan_elements";
+    if (!QFileInfo(scanDir).isDir()) { error = "driver has no buffer support"; return false; }
+    // A trigger starts each scan: the one asked for, or one already attached (a device with a
+    // hardware FIFO has no trigger directory at all)
+    if (QFileInfo(dir + "/trigger").isDir()) {
+        if (!trigger.isEmpty() && !writeAttr(dir + "/trigger/current_trigger", trigger.toLatin1())) { error = "cannot attach trigger " + trigger; return false; }
+        if (readAttr(dir + "/trigger/current_trigger").isEmpty()) { error = "no trigger attached (iio:<name>@<trigger>)"; return false; }
+    }
+
+    writeAttr(dir + "/buffer/enable", "0");
+    // Only our channels in the scan (not the timestamp): fewer bytes per read
+    for (const QString &f : QDir(scanDir).entryList(QStringList() << "*_en", QDir::Files | QDir::System)) writeAttr(scanDir + "/" + f, "0");
+    int maxBytes = 1;
+    for (Channel &ch : channels) {
+        QString base = QString("%1/in_%2").arg(scanDir, ch.name);
+        if (!writeAttr(base + "_en", "1")) { error = "no scan element " + ch.name; return false; }
+        ch.index = readAttr(base + "_index").toInt();
+        // [be|le]:[s|u]<bits>/<storagebits>[X<repeat>]>><shift>
+        QByteArray type = readAttr(base + "_type"); int bits = 0, storage = 0, shift = 0; char endian[3] = {0}, sign = 0;
+        if (sscanf(type.constData(), "%2s:%c%d/%d>>%d", endian, &sign, &bits, &storage, &shift) != 5 || storage % 8 != 0 || storage > 64) { error = "unknown scan type " + QString(type); return false; }
+        ch.bigEndian = strcmp(endian, "be") == 0; ch.isSigned = sign == 's'; ch.bits = bits; ch.bytes = storage / 8; ch.shift = shift;
+        maxBytes = qMax(maxBytes, ch.bytes);
+    }
+    // Scan layout: by index, each element aligned to its own size, whole scan to the largest
+    QVector<Channel *> order; for (Channel &ch : channels) order.append(&ch);
+    std::sort(order.begin(), order.end(), [](const Channel *a, const Channel *b) { return a->index < b->index; });
+    int pos = 0;
+    for (Channel *ch : order) { pos = (pos + ch->bytes - 1) / ch->bytes * ch->bytes; ch->offsetInScan = pos; pos += ch->bytes; }
+    scanBytes = (pos + maxBytes - 1) / maxBytes * maxBytes;
+
+    writeAttr(dir + "/buffer/length", QByteArray::number(IIO_BUFFER_LEN));
+    if (!writeAttr(dir + "/buffer/enable", "1")) { error = "cannot enable buffer"; return false; }
+    bufferEnabled = true;
+    QByteArray node = ("/dev/" + QFileInfo(dir).fileName()).toLocal8Bit();
+    devFd = ::open(node.constData(), O_RDONLY | O_NONBLOCK);
+    if (devFd < 0) { error = QString("%1: %2").arg(QString(node), strerror(errno)); return false; }
+    return true;
+}
+
+double IioSensorSource::convert(const Channel &ch, const unsigned char *data) const {
+    unsigned long long raw = 0;
+    for (int i = 0; i < ch.bytes; i++) raw |= (unsigned long long)data[ch.bigEndian ? i : ch.bytes - 1 - i] << (8 * (ch.bytes - 1 - i));
+    raw >>= ch.shift;
+    if (ch.bits < 64) raw &= (1ULL << ch.bits) - 1;
+    long long value = (long long)raw;
+    if (ch.isSigned && ch.bits < 64 && (raw & (1ULL << (ch.bits - 1)))) value -= (1LL << ch.bits);
+    return (value + ch.offset) * ch.scale;
+}
+
+void IioSensorSource::store(SensorSample *sample, int field, double value) {
+    // IIO ABI units: milli degree C, milli percent RH, lux
+    if (field == 0) sample->temp = value / 1000.0; else if (field == 1) sample->humid = value / 1000.0; else sample->lux = value;
+}
+
+int IioSensorSource::read(SensorKind, time_t, SensorSample *out, int max) {
+    if (!valid) return -1;
+    if (!buffered) {
+        SensorSample sample;
+        for (const Channel &ch : channels) {
+            char buf[32]; ssize_t n = pread(ch.fd, buf, sizeof(buf) - 1, 0);
+            if (n <= 0) return -1;   // dht11: -EIO / -ETIMEDOUT from the sensor transaction
+            buf[n] = 0; double value = ch.processed ? atof(buf) : (atof(buf) + ch.offset) * ch.scale;
+            store(&sample, ch.field, value);
+        }
+        out[0] = sample; return 1;
+    }
+
+    unsigned char buf[SENSOR_BATCH_MAX * 32];
+    int want = qMin(max, (int)sizeof(buf) / qMax(scanBytes, 1));
+    ssize_t n = ::read(devFd, buf, want * scanBytes);
+    if (n < 0) return errno == EAGAIN ? 0 : -1;
+    int scans = n / scanBytes;
+    for (int s = 0; s < scans; s++) {
+        SensorSample sample;
+        for (const Channel &ch : channels) store(&sample, ch.field, convert(ch, buf + s * scanBytes + ch.offsetInScan));
+        out[s] = sample;
+    }
+    return scans;
+}
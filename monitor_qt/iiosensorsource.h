@@ -0,0 +1,68 @@
+#ifndef IIOSENSORSOURCE_H
+#define IIOSENSORSOURCE_H
+
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+
+#include "sensorsource.h"
+
+#define IIO_SYSFS_DIR  "/sys/bus/iio/devices"
+#define IIO_BUFFER_LEN 64
+
+// Sensors behind an IIO driver: upstream dht11 (in_temp, in_humidityrelative)
+// and bh1750 (in_illuminance), or any other device with those channels.
+// Device string "iio:<name>[#n][@trigger]": n-th device called <name>, with
+// <trigger> attached for buffered capture (else the one already attached).
+//  - buffered: the channels are enabled in scan_elements and /dev/iio:deviceN
+//    is read with O_NONBLOCK (plain read(), no mmap); each call returns the
+//    scans queued since the previous one
+//  - direct: in_<ch>_input, or in_<ch>_raw with _scale/_offset, kept open and
+//    re-read with pread() at offset 0 (one sensor transaction per call)
+// Temperature and humidity come in milli-units (IIO ABI), lux as is.
+class IioSensorSource : public SensorSource
+{
+public:
+    IioSensorSource(const QString &spec, SensorKind kind, bool buffered);
+    ~IioSensorSource();
+
+    bool isValid() const { return valid; }
+    QString errorString() const { return error; }
+    int read(SensorKind kind, time_t now, SensorSample *out, int max) override;
+    QString backend() const override { return buffered ? "iio-buffered" : "iio"; }
+
+    // sysfs directory of the n-th IIO device called name, empty if none
+    static QString findDevice(const QString &name, int ordinal);
+
+private:
+    // One scan element: where it sits in a scan and how to turn it into a value
+    struct Channel {
+        QString name;       // "temp", "humidityrelative", "illuminance"
+        int field;          // 0 temp, 1 humid, 2 lux
+        int index = 0;
+        int bytes = 0, bits = 0, shift = 0, offsetInScan = 0;
+        bool isSigned = false, bigEndian = false;
+        double scale = 1.0, offset = 0.0;
+        int fd = -1;        // direct mode: attribute file
+        bool processed = false;
+    };
+
+    QString dir;
+    bool buffered;
+    bool valid = false;
+    bool bufferEnabled = false;
+    QString error;
+    QVector<Channel> channels;
+    int devFd = -1;
+    int scanBytes = 0;
+
+    bool setupBuffered(const QString &trigger);
+    bool setupDirect();
+    double convert(const Channel &ch, const unsigned char *data) const;
+    static void store(SensorSample *sample, int field, double value);
+
+    static QByteArray readAttr(const QString &path);
+    static bool writeAttr(const QString &path, const QByteArray &value);
+};
+
+#endif // IIOSENSORSOURCE_H
@@ -0,0 +1,43 @@
+#ifndef IPCPROTOCOL_H
+#define IPCPROTOCOL_H
+
+// Local IPC between monitor_daemon (core) and monitor_app_qt (kiosk UI).
+// One JSON object per line over a QLocalSocket.
+//
+// core -> UI, field "type":
+//   hello      {zones: [names], ready}            sent first, then the latest snapshot
+//   sample     {zone, ts, temp, hum, lux}
+//   buffering  {zone, count, total}
+//   rollup     {zone, tier, start, count, min[3], max[3], mean[3], labels[3]}   bucket closed
+//   trend      {zone, tier, points: [rollup fields..]}                         reply to "trend"
+//   prediction {zone, label, prob}
+//   event      {zone, label, prob}                 AC prompt
+//   status     {text}
+//   session    {ready}
+//   wifi       {state, ssid}
+//   notify     {level: info|warning|error, title, text}
+//
+// UI -> core, field "cmd":
+//   start_session                                  system time was set by the UI
+//   update_model                                   upload data, retrain, install
+//   trend      {zone, tier: minute|hour|day, count}   latest closed buckets, oldest first
+//
+// Sensor arrays are [temp, humid, lux], labels are counts per LABELS_TEXT index.
+// Label counts of a bucket keep growing for ~30 min after it closes (CSV flush).
+
+// The socket is owner only (mode 0700): the UI has to run as the daemon's user.
+#define MONITOR_SOCKET "/tmp/monitor_core.sock"
+
+// History queries (QueryServer), one JSON request per line, one reply line each.
+// from/to are unix seconds (inclusive), "id" is echoed back if present:
+//   {"op": "samples", "zone": 0, "from": .., "to": .., "limit": 500}
+//        -> {columns: [ts, temp, humid, lux, label], rows: [[..], ..], truncated}
+//   {"op": "stats",   "zone": 0, "from": .., "to": ..}
+//        -> {count, temp: {min, max, avg}, humid: {..}, lux: {..}, labels: {name: count}}
+//   {"op": "labels",  "zone": 0, "from": .., "to": ..}  -> {count, labels}
+// Only rows already flushed to CSV are visible (the last ~30 min stay in memory).
+// Owner only (mode 0700) like MONITOR_SOCKET, so query as the daemon's user.
+// Example: echo '{"op":"stats","zone":0,"from":1700000000,"to":1700007200}' | socat - UNIX-CONNECT:/tmp/monitor_query.sock
+#define MONITOR_QUERY_SOCKET "/tmp/monitor_query.sock"
+
+#endif // IPCPROTOCOL_H
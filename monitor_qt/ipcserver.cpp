@@ -0,0 +1,113 @@
+#include "ipcserver.h"
+#include "ipcprotocol.h"
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+IpcServer::IpcServer(MonitorCore *core, QObject *parent) : QObject(parent), core(core)
+{
+    server = new QLocalServer(this);
+    // Owner only: the daemon runs as root and start_session / update_model reset logging and
+    // start a retrain, so other local users must not reach it (the kiosk UI runs as root too)
+    server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(server, &QLocalServer::newConnection, this, &IpcServer::onNewConnection);
+
+    for (int z = 0; z < core->zoneList().size(); z++) { lastSample.append(QJsonObject()); lastPrediction.append(QJsonObject()); }
+
+    connect(core, &MonitorCore::sampleReady, this, [=](int zone, qint64 ts, float temp, float hum, float lux) {
+        QJsonObject msg{{"type", "sample"}, {"zone", zone}, {"ts", ts}, {"temp", temp}, {"hum", hum}, {"lux", lux}};
+        lastSample[zone] = msg; broadcast(msg);
+    });
+    connect(core, &MonitorCore::bufferingProgress, this, [=](int zone, int collected) {
+        QJsonObject msg{{"type", "buffering"}, {"zone", zone}, {"count", collected}, {"total", WINDOW_LEN}};
+        lastPrediction[zone] = msg; broadcast(msg);
+    });
+    connect(core, &MonitorCore::rollupClosed, this, [=](int zone, int tier, const RollupBucket &bucket) {
+        QJsonObject msg = bucketJson(bucket); msg["type"] = "rollup"; msg["zone"] = zone; msg["tier"] = ROLLUP_TIER_NAMES[tier];
+        broadcast(msg);
+    });
+    connect(core, &MonitorCore::predictionReady, this, [=](int zone, int labelIdx, float prob) {
+        QJsonObject msg{{"type", "prediction"}, {"zone", zone}, {"label", labelIdx}, {"text", LABELS_TEXT[labelIdx]}, {"prob", prob}};
+        lastPrediction[zone] = msg; broadcast(msg);
+    });
+    connect(core, &MonitorCore::eventDetected, this, [=](int zone, int labelIdx, float prob) {
+        broadcast(QJsonObject{{"type", "event"}, {"zone", zone}, {"label", labelIdx}, {"text", LABELS_TEXT[labelIdx]}, {"prob", prob}});
+    });
+    connect(core, &MonitorCore::statusChanged, this, [=](const QString &text) {
+        lastStatus = QJsonObject{{"type", "status"}, {"text", text}}; broadcast(lastStatus);
+    });
+    connect(core, &MonitorCore::sessionChanged, this, [=](bool ready) {
+        for (int z = 0; z < lastPrediction.size(); z++) lastPrediction[z] = QJsonObject();
+        broadcast(QJsonObject{{"type", "session"}, {"ready", ready}});
+    });
+    connect(core, &MonitorCore::wifiStateChanged, this, [=](const QString &state, const QString &ssid) {
+        lastWifi = QJsonObject{{"type", "wifi"}, {"state", state}, {"ssid", ssid}}; broadcast(lastWifi);
+    });
+    connect(core, &MonitorCore::notify, this, [=](const QString &level, const QString &title, const QString &text) {
+        broadcast(QJsonObject{{"type", "notify"}, {"level", level}, {"title", title}, {"text", text}});
+    });
+}
+
+bool IpcServer::listen(const QString &name) {
+    QLocalServer::removeServer(name); // stale socket from a previous run
+    if (!server->listen(name)) { qDebug() << "IPC: cannot listen on" << name << server->errorString(); return false; }
+    qDebug() << "IPC: listening on" << server->fullServerName();
+    return true;
+}
+
+void IpcServer::onNewConnection() {
+    while (QLocalSocket *client = server->nextPendingConnection()) {
+        clients.append(client);
+        connect(client, &QLocalSocket::readyRead, this, &IpcServer::onClientReadyRead);
+        connect(client, &QLocalSocket::disconnected, this, &IpcServer::onClientDisconnected);
+
+        QJsonArray names; for (ZonePipeline *zone : core->zoneList()) names.append(zone->config().name);
+        send(client, QJsonObject{{"type", "hello"}, {"zones", names}, {"ready", core->systemReady()}});
+        if (!lastWifi.isEmpty()) send(client, lastWifi);
+        send(client, QJsonObject{{"type", "status"}, {"text", core->status()}});
+        for (const QJsonObject &msg : lastSample) if (!msg.isEmpty()) send(client, msg);
+        for (const QJsonObject &msg : lastPrediction) if (!msg.isEmpty()) send(client, msg);
+    }
+}
+
+void IpcServer::onClientReadyRead() {
+    QLocalSocket *client = qobject_cast<QLocalSocket*>(sender());
+    while (client && client->canReadLine()) {
+        QJsonObject msg = QJsonDocument::fromJson(client->readLine()).object();
+        QString cmd = msg["cmd"].toString();
+        if (cmd == "start_session") core->initializeLoggingSession();
+        else if (cmd == "update_model") core->requestModelUpdate();
+        else if (cmd == "trend") sendTrend(client, msg);
+        else qDebug() << "IPC: unknown command" << cmd;
+    }
+}
+
+void IpcServer::onClientDisconnected() {
+    QLocalSocket *client = qobject_cast<QLocalSocket*>(sender());
+    clients.removeAll(client);
+    if (client) client->deleteLater();
+}
+
+void IpcServer::broadcast(const QJsonObject &msg) {
+    for (QLocalSocket *client : clients) send(client, msg);
+}
+
+void IpcServer::send(QLocalSocket *client, const QJsonObject &msg) {
+    client->write(QJsonDocument(msg).toJson(QJsonDocument::Compact) + "\n");
+}
+
+QJsonObject IpcServer::bucketJson(const RollupBucket &b) {
+    QJsonArray min, max, mean, labels;
+    for (int i = 0; i < ROLLUP_FIELDS; i++) { min.append(b.min[i]); max.append(b.max[i]); mean.append(b.sum[i] / b.count); }
+    for (int i = 0; i < ROLLUP_LABELS; i++) labels.append(b.labelCounts[i]);
+    return QJsonObject{{"start", b.start}, {"count", b.count}, {"min", min}, {"max", max}, {"mean", mean}, {"labels", labels}};
+}
+
+// Reply to {"cmd": "trend", zone, tier, count} with the latest closed buckets of that tier
+void IpcServer::sendTrend(QLocalSocket *client, const QJsonObject &request) {
+    int zone = request["zone"].toInt(); QString tierName = request["tier"].toString();
+    int tier = -1; for (int t = 0; t < ROLLUP_TIERS; t++) if (tierName == ROLLUP_TIER_NAMES[t]) tier = t;
+    if (zone < 0 || zone >= core->zoneList().size() || tier < 0) { qDebug() << "IPC: bad trend request" << zone << tierName; return; }
+    QJsonArray points; for (const RollupBucket &b : core->zoneList()[zone]->rollups().latest(tier, request["count"].toInt())) points.append(bucketJson(b));
+    send(client, QJsonObject{{"type", "trend"}, {"zone", zone}, {"tier", tierName}, {"points", points}});
+}
@@ -0,0 +1,45 @@
+#ifndef IPCSERVER_H
+#define IPCSERVER_H
+
+#include <QObject>
+#include <QList>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+
+#include "monitorcore.h"
+
+// Publishes MonitorCore signals to local UI clients (see ipcprotocol.h)
+// and forwards their commands. Keeps the latest values so a UI that
+// (re)connects is up to date immediately.
+class IpcServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    IpcServer(MonitorCore *core, QObject *parent = nullptr);
+    bool listen(const QString &name);
+
+private slots:
+    void onNewConnection();
+    void onClientReadyRead();
+    void onClientDisconnected();
+
+private:
+    MonitorCore *core;
+    QLocalServer *server;
+    QList<QLocalSocket*> clients;
+
+    // Snapshot replayed to new clients
+    QList<QJsonObject> lastSample;
+    QList<QJsonObject> lastPrediction;
+    QJsonObject lastStatus;
+    QJsonObject lastWifi;
+
+    void broadcast(const QJsonObject &msg);
+    void send(QLocalSocket *client, const QJsonObject &msg);
+    void sendTrend(QLocalSocket *client, const QJsonObject &request);
+    static QJsonObject bucketJson(const RollupBucket &b);
+};
+
+#endif // IPCSERVER_H
@@ -0,0 +1,122 @@
+#include "logcompactor.h"
+#include "virtualclock.h"
+#include <QDebug>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <algorithm>
+
+#include <zlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#define IOPRIO_CLASS_IDLE   3
+#define IOPRIO_CLASS_SHIFT  13
+#define IOPRIO_WHO_PROCESS  1
+
+LogCompactor::LogCompactor(const QStringList &zoneDirs, const QString &uploadMarker, const StorageConfig &cfg, QObject *parent)
+    : QThread(parent), zoneDirs(zoneDirs), uploadMarker(uploadMarker), cfg(cfg)
+{
+}
+
+LogCompactor::~LogCompactor() { stop(); }
+
+void LogCompactor::stop() {
+    { QMutexLocker lock(&mutex); stopping = true; wake.wakeAll(); }
+    wait();
+}
+
+void LogCompactor::trigger() { QMutexLocker lock(&mutex); triggered = true; wake.wakeAll(); }
+
+void LogCompactor::run() {
+    // Started with IdlePriority (SCHED_IDLE); the SD card gets the idle I/O class too
+    syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+    QMutexLocker lock(&mutex);
+    while (!stopping) {
+        triggered = false;
+        lock.unlock(); runOnce(); lock.relock();
+        if (!stopping && !triggered) wake.wait(&mutex, VirtualClock::interval(COMPACT_INTERVAL_MS));
+    }
+}
+
+// Plain or gzip file, zlib reads both transparently
+QByteArray LogCompactor::readDayFile(const QString &path) {
+    QByteArray data; QByteArray name = path.toLocal8Bit();
+    gzFile gz = gzopen(name.constData(), "rb"); if (!gz) return data;
+    char buf[65536]; int n;
+    while ((n = gzread(gz, buf, sizeof(buf))) > 0) data.append(buf, n);
+    gzclose(gz);
+    return data;
+}
+
+QString LogCompactor::dayFilePath(const QString &dir, const QString &day) {
+    QString path = QString("%1/%2.csv").arg(dir).arg(day);
+    return QFile::exists(path) ? path : path + COMPRESSED_SUFFIX;
+}
+
+// yyyy-MM-dd.csv -> yyyy-MM-dd.csv.gz, written to a temp file and renamed so readers never see half a file
+bool LogCompactor::compress(const QString &path) {
+    QString gzPath = path + COMPRESSED_SUFFIX; QString tmpPath = gzPath + ".tmp";
+    QByteArray src = path.toLocal8Bit(), tmp = tmpPath.toLocal8Bit(), dst = gzPath.toLocal8Bit();
+    int in = open(src.constData(), O_RDONLY); if (in < 0) return false;
+    gzFile gz = gzopen(tmp.constData(), "wb1");
+    if (!gz) { ::close(in); return false; }
+    char buf[65536]; ssize_t n; bool ok = true;
+    while ((n = read(in, buf, sizeof(buf))) > 0) if (gzwrite(gz, buf, n) != n) { ok = false; break; }
+    if (n < 0) ok = false;
+    ::close(in);
+    if (gzclose(gz) != Z_OK) ok = false;
+    int fd = open(tmp.constData(), O_RDONLY); if (fd >= 0) { if (fsync(fd) != 0) ok = false; ::close(fd); }
+    if (!ok || rename(tmp.constData(), dst.constData()) != 0) { unlink(tmp.constData()); return false; }
+    // Keep the day's mtime on the compressed file
+    struct stat st; if (stat(src.constData(), &st) == 0) { struct utimbuf t = {st.st_atime, st.st_mtime}; utime(dst.constData(), &t); }
+    unlink(src.constData());
+    return true;
+}
+
+void LogCompactor::runOnce() {
+    QString today = QDateTime::fromSecsSinceEpoch(VirtualClock::now()).toString("yyyy-MM-dd");
+    QString lastUpload = "1970-01-01";
+    QFile marker(uploadMarker); if (marker.open(QIODevice::ReadOnly | QIODevice::Text)) lastUpload = QTextStream(&marker).readAll().trimmed();
+    qint64 now = VirtualClock::now();
+
+    struct DayFile { QString day; QString path; qint64 size; };
+    QList<DayFile> files; int compressed = 0, removed = 0;
+    for (const QString &dirPath : zoneDirs) {
+        QDir dir(dirPath);
+        for (const QString &f : dir.entryList(QStringList() << "*.csv" COMPRESSED_SUFFIX ".tmp", QDir::Files)) QFile::remove(dir.filePath(f));   // interrupted pass
+        for (const QFileInfo &fi : dir.entryInfoList(dayFileFilters(), QDir::Files)) {
+            QString day = fi.fileName().left(10); QString path = fi.filePath(); qint64 size = fi.size();
+            bool finished = day < today && now - fi.lastModified().toSecsSinceEpoch() >= COMPACT_MIN_AGE_S;
+            if (cfg.compress && finished && day <= lastUpload && !path.endsWith(COMPRESSED_SUFFIX) && compress(path)) {
+                compressed++; path += COMPRESSED_SUFFIX; size = QFileInfo(path).size();
+            }
+            files.append(DayFile{day, path, size});
+        }
+    }
+
+    // Retention: oldest days first, today is never deleted
+    std::sort(files.begin(), files.end(), [](const DayFile &a, const DayFile &b) { return a.day < b.day; });
+    qint64 total = 0; for (const DayFile &f : files) total += f.size;
+    qint64 budget = (qint64)cfg.retentionMb * 1024 * 1024;
+    QString cutoff = cfg.retentionDays > 0 ? QDateTime::fromSecsSinceEpoch(VirtualClock::now()).date().addDays(-cfg.retentionDays).toString("yyyy-MM-dd") : QString();
+    QStringList lost;
+    for (const DayFile &f : files) {
+        if (f.day >= today) break;
+        // Age only retires uploaded days; a day that never left the device goes only when the budget forces it
+        bool uploaded = f.day <= lastUpload;
+        bool tooOld = uploaded && !cutoff.isEmpty() && f.day < cutoff; bool overBudget = budget > 0 && total > budget;
+        if (!tooOld && !overBudget) break;
+        if (!QFile::remove(f.path)) continue;
+        total -= f.size; removed++;
+        if (!uploaded) { qWarning() << "Storage: over budget, deleted" << f.path << "before it was uploaded"; lost.append(f.day); }
+    }
+    if (compressed || removed) qDebug() << "Storage:" << compressed << "compressed," << removed << "deleted," << total / 1024 << "KB of logs";
+    if (!lost.isEmpty()) { lost.removeDuplicates(); emit unuploadedDeleted(lost); }
+}
@@ -0,0 +1,58 @@
+#ifndef LOGCOMPACTOR_H
+#define LOGCOMPACTOR_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QStringList>
+
+#include "monitorconfig.h"
+
+#define COMPACT_INTERVAL_MS (60 * 60 * 1000)
+#define COMPACT_MIN_AGE_S   3600     // the logger still appends to yesterday ~30 min after midnight
+#define COMPRESSED_SUFFIX   ".gz"
+
+// Keeps the day files of all zones within the storage budget, on an idle-priority
+// thread (CPU and I/O) so logging and inference never wait for it:
+//  1. yyyy-MM-dd.csv files that are uploaded and no longer written are gzip'ed (level 1)
+//  2. uploaded days are deleted past retention_days; the oldest days, uploaded
+//     or not, while above retention_mb (unuploadedDeleted() reports the loss)
+// readDayFile() gives the CSV text of either form, for the upload path and readers.
+class LogCompactor : public QThread
+{
+    Q_OBJECT
+public:
+    LogCompactor(const QStringList &zoneDirs, const QString &uploadMarker, const StorageConfig &cfg, QObject *parent = nullptr);
+    ~LogCompactor();
+
+    void stop();
+    // Run a pass now instead of at the next interval (e.g. after an upload)
+    void trigger();
+
+    static QByteArray readDayFile(const QString &path);
+    // yyyy-MM-dd.csv if it exists, else the compressed file
+    static QString dayFilePath(const QString &dir, const QString &day);
+    static QStringList dayFileFilters() { return QStringList() << "????-??-??.csv" << "????-??-??.csv" COMPRESSED_SUFFIX; }
+
+signals:
+    // Emitted from the compactor thread: days (yyyy-MM-dd) deleted before they were uploaded
+    void unuploadedDeleted(const QStringList &days);
+
+protected:
+    void run() override;
+
+private:
+    QStringList zoneDirs;
+    QString uploadMarker;
+    StorageConfig cfg;
+
+    QMutex mutex;
+    QWaitCondition wake;
+    bool stopping = false;
+    bool triggered = false;
+
+    void runOnce();
+    bool compress(const QString &path);
+};
+
+#endif // LOGCOMPACTOR_H
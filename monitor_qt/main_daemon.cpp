@@ -0,0 +1,79 @@
+#include "monitorcore.h"
+#include "ipcserver.h"
+#include "historystore.h"
+#include "queryserver.h"
+#include "ipcprotocol.h"
+#include "virtualclock.h"
+#include "shadowevaluator.h"   // residentKb(), same RSS figure as the model load logs
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QDebug>
+
+#include <stdio.h>
+
+// Soak run summary, once per virtual hour: memory, log files on disk, detection and inference counts
+struct SoakStats { QElapsedTimer real; qint64 start = 0; long startRssKb = 0; qint64 nextReport = 0; qint64 predictions = 0; qint64 events = 0; };
+
+static void printSoak(const SoakStats &s, const MonitorCore &core) {
+    int files = 0; qint64 bytes = 0;
+    for (ZonePipeline *zone : core.zoneList()) { QDirIterator it(zone->config().dataDir, QStringList() << "*.csv" << "*.csv.gz" << "*.bin", QDir::Files); while (it.hasNext()) { it.next(); files++; bytes += it.fileInfo().size(); } }
+    double realS = s.real.elapsed() / 1000.0; long rss = ShadowEvaluator::residentKb();
+    printf("soak +%6.1fh  rss %ld kB (%+ld)  files %d (%lld kB)  predictions %lld (%.0f/s)  events %lld\n",
+           (VirtualClock::now() - s.start) / 3600.0, rss, rss - s.startRssKb, files, bytes / 1024, s.predictions, realS > 0 ? s.predictions / realS : 0.0, s.events);
+    fflush(stdout);
+}
+
+// Headless core: logging, inference and updates keep running whether or not
+// the kiosk UI (monitor_app_qt) is up.
+int main(int argc, char *argv[])
+{
+    setenv("TZ", "ICT-7", 1);
+    tzset();
+    QCoreApplication a(argc, argv);
+
+    // Soak/load testing: monitor_daemon --speed 1000 --hours 24 with "sim" zones (MONITOR_ZONES)
+    QCommandLineParser parser; parser.addHelpOption();
+    QCommandLineOption speedOpt("speed", "Run the loop on a virtual clock N times faster than real time.", "N");
+    QCommandLineOption startOpt("start", "Virtual clock start, yyyy-MM-ddTHH:mm:ss (default: now).", "time");
+    QCommandLineOption hoursOpt("hours", "Quit after H virtual hours, printing a soak summary every hour.", "H");
+    parser.addOption(speedOpt); parser.addOption(startOpt); parser.addOption(hoursOpt);
+    parser.process(a);
+    if (parser.isSet(speedOpt) || parser.isSet(startOpt)) {
+        QDateTime start = parser.isSet(startOpt) ? QDateTime::fromString(parser.value(startOpt), Qt::ISODate) : QDateTime::currentDateTime();
+        if (!start.isValid()) { fprintf(stderr, "Invalid --start time\n"); return 2; }
+        VirtualClock::start(parser.isSet(speedOpt) ? parser.value(speedOpt).toDouble() : 1.0, start.toSecsSinceEpoch());
+        qInfo() << "Virtual clock:" << VirtualClock::speed() << "x from" << start.toString(Qt::ISODate);
+    }
+
+    MonitorCore core;
+    IpcServer server(&core);
+    server.listen(MONITOR_SOCKET);
+
+    // Time-range queries over the logged history of every zone
+    QStringList zoneDirs; for (ZonePipeline *zone : core.zoneList()) zoneDirs.append(zone->config().dataDir);
+    HistoryStore history(zoneDirs);
+    QueryServer query(&history);
+    query.listen(MONITOR_QUERY_SOCKET);
+
+    SoakStats soak; QTimer soakTimer;
+    if (parser.isSet(hoursOpt)) {
+        double hours = parser.value(hoursOpt).toDouble();
+        soak.real.start(); soak.start = VirtualClock::now(); soak.startRssKb = ShadowEvaluator::residentKb();
+        QObject::connect(&core, &MonitorCore::predictionReady, [&soak]() { soak.predictions++; });
+        QObject::connect(&core, &MonitorCore::eventDetected, [&soak]() { soak.events++; });
+        soak.nextReport = soak.start + 3600;
+        QObject::connect(&soakTimer, &QTimer::timeout, [&, hours]() {
+            qint64 now = VirtualClock::now();
+            if (now >= soak.nextReport) { printSoak(soak, core); soak.nextReport += 3600; }
+            if (now - soak.start >= hours * 3600) { printSoak(soak, core); a.quit(); }
+        });
+        soakTimer.start(VirtualClock::interval(60 * 1000));
+    }
+    core.start();
+
+    return a.exec();
+}
@@ -1,4 +1,5 @@
 #include "mainwindow.h"
+#include "ipcprotocol.h"
 #include <QApplication>
 #include <QWidget>
 #include <QGridLayout>
@@ -7,11 +8,10 @@
 #include <QDateTimeEdit>
 #include <QDialogButtonBox>
 #include <QFormLayout>
-#include <QtConcurrent/QtConcurrent>
 #include <QMessageBox>
-#include <QProcess>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QJsonArray>
 #include <QJsonValue>
 #include <QLineEdit>
 #include <QPushButton>
@@ -20,43 +20,23 @@
 #include <QFile>
 #include <QTextStream>
 #include <QSpinBox>
-#include <QDir>
 #include <QStringList>
 
 // C System Headers
 #include <stdio.h>
 #include <stdlib.h>
-#include <fcntl.h>
 #include <unistd.h>
-#include <math.h>
-#include <sys/stat.h>
-#include <sys/types.h>
-#include <errno.h>
-#include <float.h>
-#include <string.h>
 
 // --- CONFIG ---
-#define DHT11_DEV       "/dev/dht11"
-#define BH1750_DEV      "/dev/bh1750"
-#define DATA_DIR        "/mnt/data"
-#define UPLOAD_MARKER   "/mnt/data/.last_upload_date"
-#define MODEL_FILE      "/mnt/data/model.tflite"
-#define ZIP_FILE        "/mnt/data/model_download.zip"
-#define EXTRACT_DIR     "/mnt/data/model_temp_extract"
 #define WIFI_CONF_FILE  "/etc/wpa_supplicant.conf"
 #define WIFI_IFACE      "wlan0"
-// Thay th? b?ng API Key th?t c?a b?n n?u c?n
-#define EI_API_KEY      "ei_938352ab999f8f68e87a537d008fc05e944ef77b9589338f8f525fcd74f3c47d"
-#define PROJECT_ID      "855133"
 
-#define UPLOAD_URL      "https://ingestion.edgeimpulse.com/api/training/files"
-#define RETRAIN_URL     "https://studio.edgeimpulse.com/v1/api/" PROJECT_ID "/jobs/retrain?impulseId=3"
-#define BUILD_URL       "https://studio.edgeimpulse.com/v1/api/" PROJECT_ID "/jobs/build-ondevice-model?type=custom&impulseId=3"
-#define JOB_STATUS_URL  "https://studio.edgeimpulse.com/v1/api/" PROJECT_ID "/jobs/%d/status"
-#define BASE_DOWNLOAD_URL "https://studio.edgeimpulse.com/v1/api/" PROJECT_ID "/deployment/download"
-#define DOWNLOAD_QUERY  "?type=custom&modelType=int8&engine=tflite&impulseId=3"
-
-const char* LABELS_TEXT[] = {"Normal", "Temp Inc, Humid Dec", "Temp Inc, Humid Inc"};
+// Trend view: rollup tier and number of buckets per range button
+struct TrendRange { const char *name; const char *tier; int periodS; int slots; };
+static const TrendRange TREND_RANGES[] = { {"6H", "minute", 60, 360}, {"7D", "hour", 3600, 168}, {"30D", "day", 86400, 30} };
+static const char* TREND_FIELDS[] = {"TEMP", "HUMID", "LIGHT"};
+static const char* TREND_UNITS[] = {"C", "%", "Lux"};
+static const char* TREND_COLORS[] = {"#FF5722", "#2196F3", "#FFC107"};
 
 // --- WIFI DIALOG CLASS ---
 class WifiDialog : public QDialog {
@@ -123,52 +103,25 @@ private:
     void toggleShift() { isShift = !isShift; for(QPushButton *btn : charBtns) { QString t = btn->text(); btn->setText(isShift ? t.toUpper() : t.toLower()); } }
 };
 
-// --- HELPERS ---
-struct MemoryStruct { char *memory; size_t size; };
-static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb, void *userp) {
-  size_t realsize = size * nmemb; struct MemoryStruct *mem = (struct MemoryStruct *)userp;
-  char *ptr = (char*)realloc(mem->memory, mem->size + realsize + 1); if(!ptr) return 0;
-  mem->memory = ptr; memcpy(&(mem->memory[mem->size]), contents, realsize); mem->size += realsize; mem->memory[mem->size] = 0; return realsize;
-}
-static size_t WriteFileCallback(void *ptr, size_t size, size_t nmemb, void *stream) { return fwrite(ptr, size, nmemb, (FILE *)stream); }
-static int parse_job_id(const char* json_str) {
-    const char *ptr = strstr(json_str, "\"id\""); if (!ptr) return -1; ptr += 4; while (*ptr == ':' || *ptr == ' ' || *ptr == '"') ptr++;
-    int id = -1; if (sscanf(ptr, "%d", &id) == 1) return id; return -1;
-}
-
 // ============================================================================
-//  MAIN WINDOW
+//  MAIN WINDOW (thin client of monitor_daemon)
 // ============================================================================
 
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
 {
-    curl_global_init(CURL_GLOBAL_ALL);
-    (void)system("modprobe dht11_driver"); (void)system("modprobe bh1750_driver");
-    struct stat st = {0}; if (stat(DATA_DIR, &st) == -1) mkdir(DATA_DIR, 0700);
-
     setupUI();
-
-    // Reset Buffers
-    buffer_head = 0; samples_collected = 0;
-    for(int i=0; i<WINDOW_LEN; i++) for(int j=0; j<RAW_FEATURE_COUNT; j++) input_buffer[i][j] = 0.0f;
-    dataBuffer.clear(); cooldownTimer = 0;
-    
-    lastPredictionIdx = 0; // Reset last prediction to Normal
-
-    // Init sensor backup values
-    lastValidTemp = 25.0f; // Gi tr? m?c d?nh an ton
-    lastValidHum = 60.0f;
-    lastValidLux = 100.0f;
-
-    isSystemReady = false; start_time = 0;
-    loadModel();
-
-    timer = new QTimer(this); connect(timer, &QTimer::timeout, this, &MainWindow::onTimerTick); timer->start(INTERVAL_S * 1000);
-    wifiTimer = new QTimer(this); connect(wifiTimer, &QTimer::timeout, this, &MainWindow::checkWifiState); wifiTimer->start(3000);
-    lastWifiState = "UNKNOWN"; onTimerTick();
+    buildZoneViews(QStringList() << "Zone 1");
+
+    // Live samples and predictions come from the core over local IPC
+    socket = new QLocalSocket(this);
+    connect(socket, &QLocalSocket::connected, this, &MainWindow::onCoreConnected);
+    connect(socket, &QLocalSocket::disconnected, this, &MainWindow::onCoreDisconnected);
+    connect(socket, &QLocalSocket::readyRead, this, &MainWindow::onCoreReadyRead);
+    reconnectTimer = new QTimer(this); connect(reconnectTimer, &QTimer::timeout, this, &MainWindow::connectToCore); reconnectTimer->start(2000);
+    connectToCore();
 }
 
-MainWindow::~MainWindow() { curl_global_cleanup(); }
+MainWindow::~MainWindow() {}
 
 void MainWindow::setupUI() {
     QWidget *centralWidget = new QWidget(this); setCentralWidget(centralWidget);
@@ -179,28 +132,20 @@ void MainWindow::setupUI() {
     lblTime->setStyleSheet("font-size: 24px; font-weight: bold; color: #FF9800; margin-bottom: 10px;");
     mainLayout->addWidget(lblTime);
 
-    QGridLayout *sensorLayout = new QGridLayout();
-    QLabel *iconTemp = new QLabel("TEMP", this); iconTemp->setAlignment(Qt::AlignCenter);
-    lblTemp = new QLabel("-- C", this); lblTemp->setAlignment(Qt::AlignCenter);
-    lblTemp->setStyleSheet("font-size: 36px; font-weight: bold; color: #FF5722;");
-    QLabel *iconHum = new QLabel("HUMID", this); iconHum->setAlignment(Qt::AlignCenter);
-    lblHum = new QLabel("-- %", this); lblHum->setAlignment(Qt::AlignCenter);
-    lblHum->setStyleSheet("font-size: 36px; font-weight: bold; color: #2196F3;");
-    QLabel *iconLux = new QLabel("LIGHT", this); iconLux->setAlignment(Qt::AlignCenter);
-    lblLux = new QLabel("-- Lux", this); lblLux->setAlignment(Qt::AlignCenter);
-    lblLux->setStyleSheet("font-size: 36px; font-weight: bold; color: #FFC107;");
-    sensorLayout->addWidget(iconTemp, 0, 0); sensorLayout->addWidget(lblTemp, 1, 0);
-    sensorLayout->addWidget(iconHum, 0, 1);  sensorLayout->addWidget(lblHum, 1, 1);
-    sensorLayout->addWidget(iconLux, 0, 2);  sensorLayout->addWidget(lblLux, 1, 2);
-    mainLayout->addLayout(sensorLayout);
-
-    mainLayout->addSpacing(20);
-    QLabel *lblPredTitle = new QLabel("AI PREDICTION:", this); lblPredTitle->setStyleSheet("font-size: 18px; color: #AAA;"); lblPredTitle->setAlignment(Qt::AlignCenter);
-    mainLayout->addWidget(lblPredTitle);
-    lblPrediction = new QLabel("System Paused (Set Time First)", this);
-    lblPrediction->setStyleSheet("font-size: 28px; font-weight: bold; color: #777; border: 2px solid #555; padding: 10px; border-radius: 5px; background-color: #333;");
-    lblPrediction->setAlignment(Qt::AlignCenter);
-    mainLayout->addWidget(lblPrediction);
+    // Zone rows are filled in by buildZoneViews() once the core reports its zones
+    zoneArea = new QWidget(this); mainLayout->addWidget(zoneArea);
+
+    // --- TREND (zone / sensor / range buttons cycle on touch) ---
+    QHBoxLayout *trendLayout = new QHBoxLayout(); QString trendBtnStyle = "font-size: 14px; background-color: #444; color: white; border: none; border-radius: 4px; min-height: 32px;";
+    btnTrendZone = new QPushButton(this); btnTrendZone->setStyleSheet(trendBtnStyle); btnTrendZone->setVisible(false);
+    btnTrendField = new QPushButton(TREND_FIELDS[trendField], this); btnTrendField->setStyleSheet(trendBtnStyle);
+    btnTrendRange = new QPushButton(TREND_RANGES[trendRange].name, this); btnTrendRange->setStyleSheet(trendBtnStyle);
+    connect(btnTrendZone, &QPushButton::clicked, [=](){ trendZone = (trendZone + 1) % zoneNames.size(); btnTrendZone->setText(zoneNames[trendZone]); requestTrend(); });
+    connect(btnTrendField, &QPushButton::clicked, [=](){ trendField = (trendField + 1) % 3; btnTrendField->setText(TREND_FIELDS[trendField]); requestTrend(); });
+    connect(btnTrendRange, &QPushButton::clicked, [=](){ trendRange = (trendRange + 1) % 3; btnTrendRange->setText(TREND_RANGES[trendRange].name); requestTrend(); });
+    trendLayout->addWidget(btnTrendZone); trendLayout->addWidget(btnTrendField); trendLayout->addWidget(btnTrendRange);
+    mainLayout->addLayout(trendLayout);
+    trend = new TrendWidget(this); mainLayout->addWidget(trend);
 
     // --- AC CONTROL WIDGET ---
     acWidget = new QWidget(this);
@@ -228,18 +173,44 @@ void MainWindow::setupUI() {
     mainLayout->addLayout(btnLayout);
 }
 
-void MainWindow::initializeLoggingSession() {
-    start_time = time(NULL); loop_count = 0; samples_collected = 0; buffer_head = 0;
-    for(int i=0; i<WINDOW_LEN; i++) for(int j=0; j<RAW_FEATURE_COUNT; j++) input_buffer[i][j] = 0.0f;
-    dataBuffer.clear(); cooldownTimer = 0; isSystemReady = true;
-    lblTime->setStyleSheet("font-size: 24px; font-weight: bold; color: #4CAF50; margin-bottom: 10px;");
-    lblPrediction->setText("Buffering Data...");
-    lblPrediction->setStyleSheet("font-size: 28px; font-weight: bold; color: #E91E63; border: 2px solid #555; padding: 10px; border-radius: 5px; background-color: #333;");
-    lblStatus->setText("System Ready. Smart Logging Active.");
-}
+// One row of values per zone, smaller fonts when several zones share the screen
+void MainWindow::buildZoneViews(const QStringList &names) {
+    qDeleteAll(zoneArea->findChildren<QWidget*>(QString(), Qt::FindDirectChildrenOnly)); delete zoneArea->layout(); zoneViews.clear(); zoneNames = names;
+    QVBoxLayout *zoneLayout = new QVBoxLayout(zoneArea); zoneLayout->setContentsMargins(0, 0, 0, 0);
+    bool multiZone = names.size() > 1; QString valueSize = multiZone ? "24px" : "36px"; QString predSize = multiZone ? "18px" : "28px";
+    QGridLayout *sensorLayout = new QGridLayout(); int col0 = multiZone ? 1 : 0;
+    QLabel *iconTemp = new QLabel("TEMP", zoneArea); iconTemp->setAlignment(Qt::AlignCenter);
+    QLabel *iconHum = new QLabel("HUMID", zoneArea); iconHum->setAlignment(Qt::AlignCenter);
+    QLabel *iconLux = new QLabel("LIGHT", zoneArea); iconLux->setAlignment(Qt::AlignCenter);
+    sensorLayout->addWidget(iconTemp, 0, col0); sensorLayout->addWidget(iconHum, 0, col0 + 1); sensorLayout->addWidget(iconLux, 0, col0 + 2);
+    for (int z = 0; z < names.size(); z++) {
+        ZoneView v;
+        v.lblTemp = new QLabel("-- C", zoneArea); v.lblTemp->setAlignment(Qt::AlignCenter);
+        v.lblTemp->setStyleSheet("font-size: " + valueSize + "; font-weight: bold; color: #FF5722;");
+        v.lblHum = new QLabel("-- %", zoneArea); v.lblHum->setAlignment(Qt::AlignCenter);
+        v.lblHum->setStyleSheet("font-size: " + valueSize + "; font-weight: bold; color: #2196F3;");
+        v.lblLux = new QLabel("-- Lux", zoneArea); v.lblLux->setAlignment(Qt::AlignCenter);
+        v.lblLux->setStyleSheet("font-size: " + valueSize + "; font-weight: bold; color: #FFC107;");
+        if (multiZone) { QLabel *lblZone = new QLabel(names[z], zoneArea); lblZone->setStyleSheet("font-size: 18px; color: #AAA;"); sensorLayout->addWidget(lblZone, z + 1, 0); }
+        sensorLayout->addWidget(v.lblTemp, z + 1, col0); sensorLayout->addWidget(v.lblHum, z + 1, col0 + 1); sensorLayout->addWidget(v.lblLux, z + 1, col0 + 2);
+        zoneViews.append(v);
+    }
+    zoneLayout->addLayout(sensorLayout);
+
+    zoneLayout->addSpacing(20);
+    QLabel *lblPredTitle = new QLabel("AI PREDICTION:", zoneArea); lblPredTitle->setStyleSheet("font-size: 18px; color: #AAA;"); lblPredTitle->setAlignment(Qt::AlignCenter);
+    zoneLayout->addWidget(lblPredTitle);
+    for (int z = 0; z < names.size(); z++) {
+        QLabel *lblPrediction = new QLabel("System Paused (Set Time First)", zoneArea);
+        lblPrediction->setStyleSheet("font-size: " + predSize + "; font-weight: bold; color: #777; border: 2px solid #555; padding: 10px; border-radius: 5px; background-color: #333;");
+        lblPrediction->setAlignment(Qt::AlignCenter);
+        zoneLayout->addWidget(lblPrediction); zoneViews[z].lblPrediction = lblPrediction;
+    }
 
-QString MainWindow::getLastUploadDate() { QFile file(UPLOAD_MARKER); if (file.open(QIODevice::ReadOnly | QIODevice::Text)) { QTextStream in(&file); return in.readAll().trimmed(); } return "1970-01-01"; }
-void MainWindow::setLastUploadDate(QString dateStr) { QFile file(UPLOAD_MARKER); if (file.open(QIODevice::WriteOnly | QIODevice::Text)) { QTextStream out(&file); out << dateStr; file.close(); } }
+    if (trendZone >= names.size()) trendZone = 0;
+    btnTrendZone->setText(names[trendZone]); btnTrendZone->setVisible(multiZone);
+
+}
 
 void MainWindow::onWifiSettingsClicked() {
     WifiDialog dialog(this);
@@ -252,153 +223,6 @@ void MainWindow::updateWifiConfig(QString ssid, QString password) {
     QFile file(WIFI_CONF_FILE); if (file.open(QIODevice::WriteOnly | QIODevice::Text)) { QTextStream out(&file); out << config; file.close(); QString cmd = QString("wpa_cli -i %1 reconfigure").arg(WIFI_IFACE); int ret = system(cmd.toStdString().c_str()); if (ret == 0) lblStatus->setText("Wifi: Apply Success. Connecting..."); else lblStatus->setText("Wifi: Apply Failed (Check Permission)"); } else lblStatus->setText("Error: Cannot write Wifi config!");
 }
 
-void MainWindow::checkWifiState() {
-    if (lblStatus->text().contains("Uploading") || lblStatus->text().contains("Training") || lblStatus->text().contains("Downloading") || lblStatus->text().contains("Building")) return;
-    QProcess process; process.start("wpa_cli", QStringList() << "-i" << WIFI_IFACE << "status"); process.waitForFinished(); QString output = process.readAllStandardOutput();
-    QString currentState = "DISCONNECTED"; QString ssid = "";
-    if (output.contains("wpa_state=COMPLETED")) { currentState = "CONNECTED"; int idx = output.indexOf("ssid="); if (idx != -1) { int end = output.indexOf("\n", idx); ssid = output.mid(idx + 5, end - (idx + 5)); } }
-    else if (output.contains("wpa_state=SCANNING")) currentState = "SCANNING"; else if (output.contains("wpa_state=ASSOCIATING") || output.contains("wpa_state=4WAY_HANDSHAKE")) currentState = "CONNECTING";
-    if (currentState != lastWifiState) {
-        if (currentState == "CONNECTED") { lblStatus->setText(QString("Wifi Connected: %1").arg(ssid)); lblStatus->setStyleSheet("color: #4CAF50; font-style: italic;"); if (!isSystemReady) QtConcurrent::run([=](){ syncTimeFromInternet(); }); if (!this->model) { lblStatus->setText("Wifi Found. Retrying Model Download..."); QtConcurrent::run([=](){ downloadAndInstallModel(); }); } }
-        else if (currentState == "DISCONNECTED") { lblStatus->setText("Wifi Disconnected!"); lblStatus->setStyleSheet("color: #F44336; font-style: italic;"); }
-        else if (currentState == "CONNECTING") { lblStatus->setText("Wifi Connecting..."); lblStatus->setStyleSheet("color: #FFC107; font-style: italic;"); }
-        lastWifiState = currentState;
-    }
-}
-
-// [BUILD/TRAIN/DOWNLOAD HELPERS]
-int MainWindow::triggerBuildJob() {
-    CURL *curl; CURLcode res; long http_code = 0; int job_id = -1;
-    struct MemoryStruct chunk; chunk.memory = (char*)malloc(1); chunk.size = 0;
-    const char* json_payload = "{\"engine\": \"tflite\", \"modelType\": \"int8\"}";
-    struct curl_slist *headers = NULL; char api_header[128]; sprintf(api_header, "x-api-key: %s", EI_API_KEY);
-    headers = curl_slist_append(headers, api_header); headers = curl_slist_append(headers, "Content-Type: application/json");
-    curl = curl_easy_init();
-    if(curl) {
-        curl_easy_setopt(curl, CURLOPT_URL, BUILD_URL); curl_easy_setopt(curl, CURLOPT_POST, 1L); curl_easy_setopt(curl, CURLOPT_POSTFIELDS, json_payload); curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback); curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk); curl_easy_setopt(curl, CURLOPT_TIMEOUT, 15L);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L); curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L); curl_easy_setopt(curl, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
-        res = curl_easy_perform(curl); curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-        if(res == CURLE_OK && http_code == 200) job_id = parse_job_id(chunk.memory);
-        curl_easy_cleanup(curl); curl_slist_free_all(headers); free(chunk.memory);
-    } return job_id;
-}
-bool MainWindow::waitForJob(int job_id, const QString &jobName) {
-    int job_finished = 0; int seconds_waited = 0; int TIMEOUT_LIMIT = 1800;
-    char job_url[256]; sprintf(job_url, JOB_STATUS_URL, job_id); char api_header[128]; sprintf(api_header, "x-api-key: %s", EI_API_KEY);
-    while(job_finished == 0 && seconds_waited < TIMEOUT_LIMIT) {
-        sleep(5); seconds_waited += 5; if(seconds_waited % 10 == 0) QMetaObject::invokeMethod(this, [=](){ lblStatus->setText(QString("%1 running (%2s)...").arg(jobName).arg(seconds_waited)); }, Qt::QueuedConnection);
-        CURL *curl = curl_easy_init();
-        if(curl) {
-            struct MemoryStruct chunk; chunk.memory = (char*)malloc(1); chunk.size = 0; struct curl_slist *headers = NULL; headers = curl_slist_append(headers, api_header);
-            curl_easy_setopt(curl, CURLOPT_URL, job_url); curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers); curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback); curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk);
-            curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L); curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L); curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L); curl_easy_setopt(curl, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
-            CURLcode res = curl_easy_perform(curl); long http_code = 0; curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-            if (res == CURLE_OK && http_code == 200) {
-                QByteArray jsonBytes(chunk.memory); QJsonDocument doc = QJsonDocument::fromJson(jsonBytes); QJsonObject rootObj = doc.object();
-                if (rootObj.contains("job")) { QJsonObject jobObj = rootObj["job"].toObject(); if (jobObj.contains("finished")) { if (jobObj["finishedSuccessful"].toBool() == true) job_finished = 1; else job_finished = -1; } }
-            } free(chunk.memory); curl_easy_cleanup(curl); curl_slist_free_all(headers);
-        } if (job_finished != 0) break;
-    } return (job_finished == 1);
-}
-bool MainWindow::attemptDownload(int retries) {
-    char clean_cmd[256]; sprintf(clean_cmd, "rm -rf %s %s", ZIP_FILE, EXTRACT_DIR); (void)system(clean_cmd);
-    int attempt = 0; bool success = false; char api_header[128]; sprintf(api_header, "x-api-key: %s", EI_API_KEY);
-    while (attempt < retries && !success) {
-        attempt++; QString statusMsg = QString("Downloading (Attempt %1/%2)...").arg(attempt).arg(retries); QMetaObject::invokeMethod(this, [=](){ lblStatus->setText(statusMsg); }, Qt::QueuedConnection);
-        CURL *curl = curl_easy_init(); long http_code = 0;
-        if(curl) {
-            FILE *fp = fopen(ZIP_FILE, "wb");
-            if(fp) {
-                struct curl_slist *headers = NULL; headers = curl_slist_append(headers, api_header); char full_url[512]; sprintf(full_url, "%s%s", BASE_DOWNLOAD_URL, DOWNLOAD_QUERY);
-                curl_easy_setopt(curl, CURLOPT_URL, full_url); curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers); curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteFileCallback); curl_easy_setopt(curl, CURLOPT_WRITEDATA, fp);
-                curl_easy_setopt(curl, CURLOPT_TIMEOUT, 60L); curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L); curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L); curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L); curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L); curl_easy_setopt(curl, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
-                CURLcode res = curl_easy_perform(curl); curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code); fclose(fp); curl_slist_free_all(headers); if (res == CURLE_OK && http_code == 200) success = true;
-            } curl_easy_cleanup(curl);
-        } if (!success) sleep(2);
-    } return success;
-}
-
-void MainWindow::performUpdateSequence() {
-    if (!isSystemReady) { QMetaObject::invokeMethod(this, [=](){ QMessageBox::warning(this, "Error", "Time not synced yet."); }, Qt::QueuedConnection); return; }
-    QString currentDateStr = QDateTime::currentDateTime().toString("yyyy-MM-dd"); QString lastUploadDateStr = getLastUploadDate();
-    QDir dir(DATA_DIR); QStringList filters; filters << "*.csv"; dir.setNameFilters(filters); dir.setSorting(QDir::Name);
-    QStringList filesToUpload; QStringList entryList = dir.entryList();
-    foreach (QString filename, entryList) { QString fileDateStr = filename.section('.', 0, 0); if (fileDateStr > lastUploadDateStr && fileDateStr < currentDateStr) filesToUpload.append(filename); }
-    if (filesToUpload.isEmpty()) { QMetaObject::invokeMethod(this, [=](){ lblStatus->setText("No past files to upload."); QMessageBox::information(this, "Info", "All past data is already uploaded."); }, Qt::QueuedConnection); return; }
-
-    char api_header[128]; sprintf(api_header, "x-api-key: %s", EI_API_KEY); int max_retries = 5;
-    int fileIdx = 0;
-    for (const QString &filename : filesToUpload) {
-        fileIdx++; QString fullPath = QString("%1/%2").arg(DATA_DIR).arg(filename); QString fileDateStr = filename.section('.', 0, 0); bool upload_ok = false;
-        for (int attempt = 1; attempt <= max_retries; attempt++) {
-            QString msg = QString("Uploading %1 (%2/%3) - Try %4").arg(filename).arg(fileIdx).arg(filesToUpload.size()).arg(attempt); QMetaObject::invokeMethod(this, [=](){ lblStatus->setText(msg); }, Qt::QueuedConnection);
-            CURL *curl = curl_easy_init(); long http_code = 0; CURLcode res = CURLE_FAILED_INIT;
-            if(curl) {
-                curl_mime *form = curl_mime_init(curl); curl_mimepart *field = curl_mime_addpart(form); curl_mime_name(field, "data"); curl_mime_filedata(field, fullPath.toStdString().c_str()); curl_mime_type(field, "text/csv");
-                struct curl_slist *headers = NULL; headers = curl_slist_append(headers, api_header); headers = curl_slist_append(headers, "x-disallow-duplicates: 1"); headers = curl_slist_append(headers, "x-label: normal");
-                curl_easy_setopt(curl, CURLOPT_URL, UPLOAD_URL); curl_easy_setopt(curl, CURLOPT_MIMEPOST, form); curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers); curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L); curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L); curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L); curl_easy_setopt(curl, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
-                res = curl_easy_perform(curl); curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code); curl_easy_cleanup(curl); curl_mime_free(form); curl_slist_free_all(headers);
-            }
-            if(res == CURLE_OK && (http_code == 200 || http_code == 201)) { upload_ok = true; break; } else sleep(2);
-        }
-        if (upload_ok) setLastUploadDate(fileDateStr); else { QMetaObject::invokeMethod(this, [=](){ lblStatus->setText("Upload Error at " + filename); QMessageBox::warning(this, "Error", "Failed to upload " + filename); }, Qt::QueuedConnection); return; }
-    }
-
-    int job_id = -1;
-    for (int attempt = 1; attempt <= max_retries; attempt++) {
-        QMetaObject::invokeMethod(this, [=](){ lblStatus->setText(QString("Triggering Retrain (%1/%2)...").arg(attempt).arg(max_retries)); }, Qt::QueuedConnection);
-        CURL *curl = curl_easy_init(); long http_code = 0; CURLcode res = CURLE_FAILED_INIT;
-        if(curl) {
-            struct MemoryStruct chunk; chunk.memory = (char*)malloc(1); chunk.size = 0; struct curl_slist *headers = NULL; headers = curl_slist_append(headers, api_header); headers = curl_slist_append(headers, "Content-Type: application/json");
-            curl_easy_setopt(curl, CURLOPT_URL, RETRAIN_URL); curl_easy_setopt(curl, CURLOPT_POST, 1L); curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers); curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback); curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk); curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L); curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L); curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L); curl_easy_setopt(curl, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
-            res = curl_easy_perform(curl); curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code); if(res == CURLE_OK && http_code == 200) job_id = parse_job_id(chunk.memory); free(chunk.memory); curl_easy_cleanup(curl); curl_slist_free_all(headers);
-        } if (job_id != -1) break; else sleep(2);
-    }
-    if (job_id == -1) { QMetaObject::invokeMethod(this, [=](){ lblStatus->setText("Trigger Failed!"); }, Qt::QueuedConnection); return; }
-    if (!waitForJob(job_id, "Training")) { QMetaObject::invokeMethod(this, [=](){ lblStatus->setText("Training Failed!"); }, Qt::QueuedConnection); return; }
-    int build_id = -1;
-    for (int attempt = 1; attempt <= max_retries; attempt++) { QMetaObject::invokeMethod(this, [=](){ lblStatus->setText(QString("Triggering Build (%1/%2)...").arg(attempt).arg(max_retries)); }, Qt::QueuedConnection); build_id = triggerBuildJob(); if (build_id != -1) break; else sleep(2); }
-    if (build_id == -1) { QMetaObject::invokeMethod(this, [=](){ lblStatus->setText("Build Trigger Failed!"); }, Qt::QueuedConnection); return; }
-    if (!waitForJob(build_id, "Building")) { QMetaObject::invokeMethod(this, [=](){ lblStatus->setText("Build Failed!"); }, Qt::QueuedConnection); return; }
-    if (attemptDownload(5)) this->installDownloadedModel(); else QMetaObject::invokeMethod(this, [=](){ lblStatus->setText("Download Failed!"); }, Qt::QueuedConnection);
-}
-
-void MainWindow::downloadAndInstallModel() {
-    bool success = attemptDownload(5);
-    if (!success) {
-        QMetaObject::invokeMethod(this, [=](){ lblStatus->setText("Cache missing. Re-building..."); }, Qt::QueuedConnection);
-        int build_id = triggerBuildJob(); bool build_ok = (build_id != -1) && waitForJob(build_id, "Emergency Build");
-        if (build_ok) { QMetaObject::invokeMethod(this, [=](){ lblStatus->setText("Build OK. Downloading..."); }, Qt::QueuedConnection); success = attemptDownload(5); }
-        else { QMetaObject::invokeMethod(this, [=](){ lblStatus->setText("Recovery Build Failed."); }, Qt::QueuedConnection); return; }
-    } if (success) this->installDownloadedModel(); else QMetaObject::invokeMethod(this, [=](){ lblStatus->setText("Recovery Failed (Network)."); }, Qt::QueuedConnection);
-}
-
-void MainWindow::installDownloadedModel() {
-    QMetaObject::invokeMethod(this, [=](){ lblStatus->setText("Installing Model..."); }, Qt::QueuedConnection);
-    char cmd[512]; sprintf(cmd, "mkdir -p %s", EXTRACT_DIR); (void)system(cmd); sprintf(cmd, "unzip -o %s -d %s > /dev/null", ZIP_FILE, EXTRACT_DIR);
-    if (system(cmd) != 0) { QMetaObject::invokeMethod(this, [=](){ lblStatus->setText("Unzip Failed!"); QMessageBox::warning(this, "Error", "Downloaded file is corrupted."); }, Qt::QueuedConnection); return; }
-    sprintf(cmd, "mv %s/trained.tflite %s", EXTRACT_DIR, MODEL_FILE); if(system(cmd) != 0) { sprintf(cmd, "find %s -name '*.tflite' -exec mv {} %s \\; -quit", EXTRACT_DIR, MODEL_FILE); (void)system(cmd); }
-    sprintf(cmd, "rm -rf %s %s", ZIP_FILE, EXTRACT_DIR); (void)system(cmd);
-    QMetaObject::invokeMethod(this, [=]() { this->loadModel(); if (this->model) { lblStatus->setText("Model Updated!"); QMessageBox::information(this, "Success", "Model updated successfully!"); } }, Qt::QueuedConnection);
-}
-
-void MainWindow::syncTimeFromInternet() {
-    int max_retries = 5; int attempt = 0; bool success = false;
-    while (attempt < max_retries && !success) {
-        attempt++; if (!lblStatus->text().contains("Uploading")) lblStatus->setText(QString("Syncing Time (%1/%2)...").arg(attempt).arg(max_retries));
-        QApplication::processEvents(); CURL *curl = curl_easy_init();
-        if (curl) {
-            struct MemoryStruct chunk; chunk.memory = (char*)malloc(1); chunk.size = 0;
-            curl_easy_setopt(curl, CURLOPT_URL, "http://worldtimeapi.org/api/timezone/Asia/Ho_Chi_Minh"); curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback); curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk); curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L); curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L); curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L); curl_easy_setopt(curl, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
-            if (curl_easy_perform(curl) == CURLE_OK) {
-                QByteArray jsonBytes(chunk.memory); QJsonDocument doc = QJsonDocument::fromJson(jsonBytes); QJsonObject obj = doc.object();
-                if (obj.contains("unixtime")) { qint64 unixtime = obj["unixtime"].toVariant().toLongLong(); QString cmd = QString("date -s @%1").arg(unixtime); if (system(cmd.toStdString().c_str()) == 0) { QMetaObject::invokeMethod(this, [=](){ initializeLoggingSession(); lblStatus->setText("Time Synced & System Started!"); }, Qt::QueuedConnection); success = true; } }
-            } curl_easy_cleanup(curl); free(chunk.memory);
-        } if (!success && attempt < max_retries) sleep(2);
-    } if (!success) lblStatus->setText("Net Sync Failed. Please Set Time Manually.");
-}
-
 void MainWindow::onSettingsClicked() {
     QDialog dialog(this); dialog.setWindowTitle("System Time Settings");
     dialog.setStyleSheet("QDialog { background-color: #333; color: white; } QLabel { font-size: 20px; font-weight: bold; color: #AAA; } QSpinBox { height: 60px; font-size: 28px; background-color: #555; color: white; border: 2px solid #777; } QSpinBox::up-button, QSpinBox::down-button { width: 60px; } QPushButton { height: 60px; font-size: 24px; background-color: #009688; color: white; border-radius: 5px; min-width: 120px; } QPushButton:pressed { background-color: #00796B; }");
@@ -414,137 +238,105 @@ void MainWindow::onSettingsClicked() {
     connect(btnOk, &QPushButton::clicked, &dialog, &QDialog::accept); connect(btnCancel, &QPushButton::clicked, &dialog, &QDialog::reject); dialog.setMinimumWidth(400);
     if (dialog.exec() == QDialog::Accepted) {
         QDate newDate(sbYear->value(), sbMonth->value(), sbDay->value()); QTime newTime(sbHour->value(), sbMinute->value(), 0);
-        if (newDate.isValid()) { QDateTime newDateTime(newDate, newTime); QString cmd = QString("date -s \"%1\"").arg(newDateTime.toString("yyyy-MM-dd HH:mm:ss")); if (system(cmd.toStdString().c_str()) == 0) { initializeLoggingSession(); QMessageBox::information(this, "Success", "Time updated & Data logging started!"); onTimerTick(); } else QMessageBox::critical(this, "Error", "Cannot set time (Root required)!"); }
+        if (newDate.isValid()) { QDateTime newDateTime(newDate, newTime); QString cmd = QString("date -s \"%1\"").arg(newDateTime.toString("yyyy-MM-dd HH:mm:ss")); if (system(cmd.toStdString().c_str()) == 0) { sendCommand("start_session"); QMessageBox::information(this, "Success", "Time updated & Data logging started!"); } else QMessageBox::critical(this, "Error", "Cannot set time (Root required)!"); }
     }
 }
 
 void MainWindow::onUpdateModelClicked() {
     if (!isSystemReady) { QMessageBox::warning(this, "Not Ready", "Please set system time first!"); return; }
-    lblStatus->setText("Starting Update Process..."); lastWifiState = "UPDATING"; QtConcurrent::run([=]() { this->performUpdateSequence(); });
+    lblStatus->setText("Starting Update Process..."); sendCommand("update_model");
 }
 
-void MainWindow::onTimerTick() {
-    // 1. READ SENSOR
-    float raw_temp = 0, raw_hum = 0, raw_lux = 0;
-    int retDHT = readDHT11(&raw_temp, &raw_hum);
-    int retBH = readBH1750(&raw_lux);
-    
-    if (retDHT == 0 && raw_temp != 0 && raw_hum != 0) {
-        lastValidTemp = raw_temp;
-        lastValidHum = raw_hum;
-    } else {
-        qDebug() << "Sensor Error or Zero Detected! Using Last Known Values.";
-    }
-    
-    if (retBH == 0) lastValidLux = raw_lux;
-
-    float finalTemp = lastValidTemp;
-    float finalHumid = lastValidHum;
-    float finalLux = lastValidLux;
-
-    lblTemp->setText(QString::number(finalTemp, 'f', 1) + " C");
-    lblHum->setText(QString::number(finalHumid, 'f', 1) + " %");
-    lblLux->setText(QString::number(finalLux, 'f', 0) + " Lux");
-
-    time_t now = time(NULL); 
-    if (isSystemReady) lblTime->setText(QDateTime::fromTime_t(now).toString("dddd, dd MMM yyyy - HH:mm")); 
-    else lblTime->setText("Waiting for Time Sync...");
-    
-    if (!isSystemReady) return;
-
-    // 2. PREPARE DATA
-    BufferedSample sample; sample.timestamp = (long)now; sample.temp = finalTemp; sample.humid = finalHumid; sample.lux = finalLux; sample.label = "normal";
-    float all_feats[9]; calcTimeFeatures(now, all_feats); all_feats[6] = finalTemp; all_feats[7] = finalHumid; all_feats[8] = finalLux; memcpy(sample.features, all_feats, sizeof(float)*9);
-    dataBuffer.append(sample);
-
-    // 3. DETECT EVENTS
-    if (dataBuffer.size() > DETECTION_WINDOW && cooldownTimer == 0) {
-        int currentIdx = dataBuffer.size() - 1;
-        int pastIdx = currentIdx - DETECTION_WINDOW;
-        
-        float avgTempCurrent = (dataBuffer[currentIdx].temp + dataBuffer[currentIdx-1].temp + dataBuffer[currentIdx-2].temp) / 3.0f;
-        float avgTempPast = (dataBuffer[pastIdx].temp + dataBuffer[pastIdx+1].temp + dataBuffer[pastIdx+2].temp) / 3.0f;
-        
-        float avgHumidCurrent = (dataBuffer[currentIdx].humid + dataBuffer[currentIdx-1].humid + dataBuffer[currentIdx-2].humid) / 3.0f;
-        float avgHumidPast = (dataBuffer[pastIdx].humid + dataBuffer[pastIdx+1].humid + dataBuffer[pastIdx+2].humid) / 3.0f;
-
-        float deltaTemp = avgTempCurrent - avgTempPast;
-        float deltaHumid = avgHumidCurrent - avgHumidPast;
-        
-        QString detectedEvent = "";
-        
-        if (deltaTemp >= THRESHOLD_TEMP_RISE) {
-            if (deltaHumid >= THRESHOLD_HUMID_RISE) detectedEvent = "temp_inc, humid_inc";
-            else if (deltaHumid <= THRESHOLD_HUMID_DROP) detectedEvent = "temp_inc, humid_dec";
-        }
-
-        if (!detectedEvent.isEmpty()) {
-            // Relabel Backwards
-            int labelEndIdx = pastIdx; int labelStartIdx = labelEndIdx - PREDICTION_OFFSET; if (labelStartIdx < 0) labelStartIdx = 0;
-            for (int i = labelStartIdx; i <= labelEndIdx; i++) if (dataBuffer[i].label == "normal") dataBuffer[i].label = detectedEvent;
-            
-            cooldownTimer = 90; 
-        }
-    } else { if (cooldownTimer > 0) cooldownTimer--; }
-
-    // 4. FLUSH TO DISK
-    while (dataBuffer.size() > BUFFER_MAX_SIZE) {
-        BufferedSample toWrite = dataBuffer.takeFirst();
-        QDateTime currentDT = QDateTime::fromTime_t(toWrite.timestamp); QString todayFileName = currentDT.toString("yyyy-MM-dd") + ".csv"; QString todayFullLink = QString("%1/%2").arg(DATA_DIR).arg(todayFileName);
-        QByteArray fileNameBytes = todayFullLink.toLocal8Bit(); FILE *fp = fopen(fileNameBytes.constData(), "a");
-        if (fp) {
-             if (ftell(fp) == 0) fprintf(fp, "timestamp,min_sin,min_cos,temp,humid,lux,label\n");
-             fprintf(fp, "%ld,%.5f,%.5f,%.1f,%.1f,%.1f,%s\n", toWrite.timestamp * 1000, toWrite.features[0], toWrite.features[1], toWrite.features[6], toWrite.features[7], toWrite.features[8], toWrite.label.toStdString().c_str());
-             fclose(fp);
-        }
-    }
+// --- CORE CONNECTION ---
+void MainWindow::connectToCore() {
+    if (socket->state() == QLocalSocket::UnconnectedState) socket->connectToServer(MONITOR_SOCKET);
+}
+
+void MainWindow::onCoreConnected() { reconnectTimer->stop(); qDebug() << "Connected to monitor core"; }
+
+void MainWindow::onCoreDisconnected() {
+    lblStatus->setText("Core Service Not Running. Reconnecting..."); lblStatus->setStyleSheet("color: #F44336; font-style: italic;");
+    reconnectTimer->start(2000);
+}
+
+void MainWindow::sendCommand(const QString &cmd, const QJsonObject &args) {
+    if (socket->state() != QLocalSocket::ConnectedState) { QMessageBox::warning(this, "Error", "Core service is not running!"); return; }
+    QJsonObject msg = args; msg["cmd"] = cmd;
+    socket->write(QJsonDocument(msg).toJson(QJsonDocument::Compact) + "\n");
+}
+
+// --- TREND ---
+// History comes once per selection from the rollups, afterwards only closed buckets are appended
+void MainWindow::requestTrend() {
+    const TrendRange &r = TREND_RANGES[trendRange];
+    trend->setSeries(QVector<TrendPoint>(), r.periodS, r.slots, TREND_UNITS[trendField], QColor(TREND_COLORS[trendField]));
+    if (socket->state() == QLocalSocket::ConnectedState) sendCommand("trend", QJsonObject{{"zone", trendZone}, {"tier", r.tier}, {"count", r.slots}});
+}
 
-    // 5. INFERENCE
-    float raw_input[RAW_FEATURE_COUNT]; raw_input[0] = all_feats[0]; raw_input[1] = all_feats[1]; raw_input[2] = all_feats[6]; raw_input[3] = all_feats[7]; raw_input[4] = all_feats[8];
-    buffer_head = (buffer_head + 1) % WINDOW_LEN; for(int k=0; k<RAW_FEATURE_COUNT; k++) input_buffer[buffer_head][k] = raw_input[k];
-    samples_collected++;
-    if (samples_collected >= WINDOW_LEN) runInference(); else lblPrediction->setText(QString("Buffering... %1/%2").arg(samples_collected).arg(WINDOW_LEN));
-    loop_count++;
+bool MainWindow::isTrendMessage(const QJsonObject &msg) const {
+    return msg["zone"].toInt() == trendZone && msg["tier"].toString() == TREND_RANGES[trendRange].tier;
 }
 
-int MainWindow::readDHT11(float *temp, float *hum) { int fd = open(DHT11_DEV, O_RDONLY); if (fd < 0) return -1; char tmp[64] = {0}; int ret = -1; if (read(fd, tmp, 63) > 0) { if (sscanf(tmp, "Temp: %f C, Hum: %f %%", temp, hum) == 2) ret = 0; else if(sscanf(tmp, "%f %f", temp, hum) == 2) ret = 0; } ::close(fd); return ret; }
-int MainWindow::readBH1750(float *lux) { int fd = open(BH1750_DEV, O_RDONLY); if (fd < 0) return -1; char tmp[32] = {0}; int ret = -1; if (read(fd, tmp, 31) > 0) { *lux = atof(tmp); ret = 0; } ::close(fd); return ret; }
-void MainWindow::calcTimeFeatures(time_t t, float *features) { struct tm *tm_info = localtime(&t); float min_of_day = tm_info->tm_hour * 60.0 + tm_info->tm_min; features[0] = sin(2 * M_PI * min_of_day / 1440.0); features[1] = cos(2 * M_PI * min_of_day / 1440.0); features[2] = sin(2 * M_PI * tm_info->tm_wday / 7.0); features[3] = cos(2 * M_PI * tm_info->tm_wday / 7.0); features[4] = sin(2 * M_PI * tm_info->tm_yday / 366.0); features[5] = cos(2 * M_PI * tm_info->tm_yday / 366.0); }
+TrendPoint MainWindow::trendPoint(const QJsonObject &bucket) const {
+    TrendPoint p; p.start = bucket["start"].toVariant().toLongLong();
+    p.min = bucket["min"].toArray()[trendField].toDouble(); p.max = bucket["max"].toArray()[trendField].toDouble(); p.mean = bucket["mean"].toArray()[trendField].toDouble();
+    return p;
+}
 
-void MainWindow::loadModel() {
-    model.reset(); interpreter.reset(); model = tflite::FlatBufferModel::BuildFromFile(MODEL_FILE);
-    if (!model) { qDebug() << "ERROR: Model missing..."; lblStatus->setText("Model Error! Recovering..."); static bool is_recovering = false; if (!is_recovering) { is_recovering = true; QtConcurrent::run([=](){ downloadAndInstallModel(); is_recovering = false; }); } return; }
-    tflite::ops::builtin::BuiltinOpResolver resolver; tflite::InterpreterBuilder builder(*model, resolver); builder(&interpreter);
-    if (!interpreter) { lblStatus->setText("Failed to construct interpreter!"); return; } if (interpreter->AllocateTensors() != kTfLiteOk) { lblStatus->setText("Tensor Alloc Failed!"); return; }
-    qDebug() << "Model Loaded Successfully"; lblStatus->setText("Model Loaded.");
+void MainWindow::onCoreReadyRead() {
+    while (socket->canReadLine()) handleCoreMessage(QJsonDocument::fromJson(socket->readLine()).object());
 }
 
-void MainWindow::runInference() {
-    if (!interpreter) return;
-    float processed_input[MODEL_INPUT_COUNT];
-    for (int col = 0; col < RAW_FEATURE_COUNT; col++) {
-        float sum = 0.0f; float min_val = FLT_MAX; float max_val = -FLT_MAX; float ma6_sum = 0.0f;
-        for (int i = 0; i < WINDOW_LEN; i++) { int buf_idx = (buffer_head + 1 + i) % WINDOW_LEN; float val = input_buffer[buf_idx][col]; sum += val; if (val < min_val) min_val = val; if (val > max_val) max_val = val; if (i >= WINDOW_LEN - MA_WINDOW) ma6_sum += val; }
-        float avg = sum / WINDOW_LEN; float ma6 = ma6_sum / MA_WINDOW; processed_input[col * 4 + 0] = avg; processed_input[col * 4 + 1] = min_val; processed_input[col * 4 + 2] = max_val; processed_input[col * 4 + 3] = ma6;
+void MainWindow::setSessionReady(bool ready) {
+    isSystemReady = ready;
+    if (!ready) return;
+    lblTime->setStyleSheet("font-size: 24px; font-weight: bold; color: #4CAF50; margin-bottom: 10px;");
+    QString predSize = zoneViews.size() > 1 ? "18px" : "28px";
+    for (const ZoneView &v : zoneViews) {
+        v.lblPrediction->setText("Buffering Data...");
+        v.lblPrediction->setStyleSheet("font-size: " + predSize + "; font-weight: bold; color: #E91E63; border: 2px solid #555; padding: 10px; border-radius: 5px; background-color: #333;");
+    }
+}
+
+void MainWindow::handleCoreMessage(const QJsonObject &msg) {
+    QString type = msg["type"].toString(); int z = msg["zone"].toInt();
+    if (msg.contains("zone") && (z < 0 || z >= zoneViews.size())) return;
+
+    if (type == "hello") {
+        QStringList names; for (const QJsonValue &v : msg["zones"].toArray()) names.append(v.toString());
+        buildZoneViews(names); setSessionReady(msg["ready"].toBool()); requestTrend();
+    }
+    else if (type == "rollup") { if (isTrendMessage(msg)) trend->append(trendPoint(msg)); }
+    else if (type == "trend") {
+        if (!isTrendMessage(msg)) return;   // reply to an older selection
+        const TrendRange &r = TREND_RANGES[trendRange];
+        QVector<TrendPoint> points; for (const QJsonValue &v : msg["points"].toArray()) points.append(trendPoint(v.toObject()));
+        trend->setSeries(points, r.periodS, r.slots, TREND_UNITS[trendField], QColor(TREND_COLORS[trendField]));
+    }
+    else if (type == "sample") {
+        zoneViews[z].lblTemp->setText(QString::number(msg["temp"].toDouble(), 'f', 1) + " C");
+        zoneViews[z].lblHum->setText(QString::number(msg["hum"].toDouble(), 'f', 1) + " %");
+        zoneViews[z].lblLux->setText(QString::number(msg["lux"].toDouble(), 'f', 0) + " Lux");
+        if (isSystemReady) lblTime->setText(QDateTime::fromTime_t(msg["ts"].toVariant().toLongLong()).toString("dddd, dd MMM yyyy - HH:mm")); 
+        else lblTime->setText("Waiting for Time Sync...");
+    }
+    else if (type == "buffering") zoneViews[z].lblPrediction->setText(QString("Buffering... %1/%2").arg(msg["count"].toInt()).arg(msg["total"].toInt()));
+    else if (type == "prediction") zoneViews[z].lblPrediction->setText(QString("%1 (%2%)").arg(msg["text"].toString()).arg(msg["prob"].toDouble() * 100, 0, 'f', 1));
+    else if (type == "event") {
+        QString where = zoneViews.size() > 1 ? zoneNames[z] + ": " : QString();
+        acLabel->setText(where + msg["text"].toString() + "\nDetected. Turn on AC?");
+        acWidget->setVisible(true);
+    }
+    else if (type == "status") lblStatus->setText(msg["text"].toString());
+    else if (type == "session") setSessionReady(msg["ready"].toBool());
+    else if (type == "wifi") {
+        QString state = msg["state"].toString();
+        if (state == "CONNECTED") lblStatus->setStyleSheet("color: #4CAF50; font-style: italic;");
+        else if (state == "DISCONNECTED") lblStatus->setStyleSheet("color: #F44336; font-style: italic;");
+        else if (state == "CONNECTING") lblStatus->setStyleSheet("color: #FFC107; font-style: italic;");
     }
-    int input_idx = interpreter->inputs()[0]; TfLiteTensor* input_tensor = interpreter->tensor(input_idx);
-    if (input_tensor->type == kTfLiteInt8) { float scale = input_tensor->params.scale; int32_t zero_point = input_tensor->params.zero_point; int8_t* input_data = interpreter->typed_input_tensor<int8_t>(0); for (int i = 0; i < MODEL_INPUT_COUNT; i++) { float quant_val = (processed_input[i] / scale) + zero_point; if (quant_val > 127) quant_val = 127; if (quant_val < -128) quant_val = -128; input_data[i] = (int8_t)round(quant_val); } }
-    else { float* input_data = interpreter->typed_input_tensor<float>(0); for(int i=0; i<MODEL_INPUT_COUNT; i++) input_data[i] = processed_input[i]; }
-    if (interpreter->Invoke() != kTfLiteOk) { lblStatus->setText("Inference Failed!"); return; }
-
-    int output_idx = interpreter->outputs()[0]; TfLiteTensor* output_tensor = interpreter->tensor(output_idx); float probs[NUM_LABELS];
-    if (output_tensor->type == kTfLiteInt8) { float scale = output_tensor->params.scale; int32_t zero_point = output_tensor->params.zero_point; int8_t* out_data = interpreter->typed_output_tensor<int8_t>(0); for(int i=0; i<NUM_LABELS; i++) probs[i] = (out_data[i] - zero_point) * scale; }
-    else { float* out_data = interpreter->typed_output_tensor<float>(0); for(int i=0; i<NUM_LABELS; i++) probs[i] = out_data[i]; }
-    int max_idx = 0; for(int i=1; i<NUM_LABELS; i++) if(probs[i] > probs[max_idx]) max_idx = i;
-    lblPrediction->setText(QString("%1 (%2%)").arg(LABELS_TEXT[max_idx]).arg(probs[max_idx] * 100, 0, 'f', 1));
-
-    if (max_idx != 0 && lastPredictionIdx == 0) {
-        if (probs[max_idx] > 0.6) {
-             if (acWidget && acLabel) {
-                 acLabel->setText(QString(LABELS_TEXT[max_idx]) + "\nDetected. Turn on AC?");
-                 acWidget->setVisible(true);
-             }
-        }
+    else if (type == "notify") {
+        QString level = msg["level"].toString(), title = msg["title"].toString(), text = msg["text"].toString();
+        if (level == "info") QMessageBox::information(this, title, text); else QMessageBox::warning(this, title, text);
     }
-    lastPredictionIdx = max_idx;
 }
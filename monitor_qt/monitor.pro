@@ -0,0 +1,12 @@
+# monitor_core: thư viện lõi không GUI (sensor, feature, TFLite, log, upload)
+# monitor_daemon: tiến trình headless chạy lõi
+# monitor_app_qt: giao diện kiosk, chỉ nhận dữ liệu từ daemon qua local socket
+# bench_features: đo tốc độ và kiểm tra các nhân trích xuất feature (scalar/SSE/AVX2/NEON)
+TEMPLATE = subdirs
+
+SUBDIRS = core daemon app bench
+core.file = monitor_core.pro
+daemon.file = monitor_daemon.pro
+daemon.depends = core
+app.file = monitor_app.pro
+bench.file = bench_features.pro
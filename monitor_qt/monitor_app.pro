@@ -1,14 +1,18 @@
-QT       += core gui widgets concurrent
+QT       += core gui widgets network
 TARGET = monitor_app_qt
 TEMPLATE = app
 
 # --- QUAN TRỌNG: Dùng C++17 để fix lỗi make_unique và template-id của TFLite ---
 CONFIG += c++17
 
-# Link thư viện (Edge Impulse cần libcurl và tflite)
-LIBS += -lcurl -ltensorflow-lite -ldl -latomic
+OBJECTS_DIR = .obj/app
+MOC_DIR = .moc/app
 
+# Giao diện không link TFLite/libcurl: mọi xử lý nằm trong monitor_daemon
 SOURCES += main.cpp \
-           mainwindow.cpp
+           mainwindow.cpp \
+           trendwidget.cpp
 
-HEADERS += mainwindow.h
+HEADERS += mainwindow.h \
+           trendwidget.h \
+           ipcprotocol.h
@@ -0,0 +1,51 @@
+QT       = core network concurrent
+TARGET = monitor_core
+TEMPLATE = lib
+CONFIG += staticlib c++17
+
+OBJECTS_DIR = .obj/core
+MOC_DIR = .moc/core
+
+# qmake CONFIG+=tflite_static_ops: chỉ link các kernel TFLite mà impulse dùng (không có BuiltinOpResolver dự phòng)
+tflite_static_ops: DEFINES += TFLITE_STATIC_OPS
+
+SOURCES += monitorcore.cpp \
+           monitorconfig.cpp \
+           zonepipeline.cpp \
+           sensorsource.cpp \
+           iiosensorsource.cpp \
+           replaysensorsource.cpp \
+           virtualclock.cpp \
+           decimator.cpp \
+           featurekernels.cpp \
+           rollupstore.cpp \
+           logcompactor.cpp \
+           shadowevaluator.cpp \
+           headtrainer.cpp \
+           realtimesampler.cpp \
+           telemetrypublisher.cpp \
+           opresolver.cpp \
+           ipcserver.cpp \
+           historystore.cpp \
+           queryserver.cpp
+
+HEADERS += monitorcore.h \
+           monitorconfig.h \
+           zonepipeline.h \
+           sensorsource.h \
+           iiosensorsource.h \
+           replaysensorsource.h \
+           virtualclock.h \
+           decimator.h \
+           featurekernels.h \
+           rollupstore.h \
+           logcompactor.h \
+           shadowevaluator.h \
+           headtrainer.h \
+           realtimesampler.h \
+           telemetrypublisher.h \
+           opresolver.h \
+           ipcserver.h \
+           historystore.h \
+           queryserver.h \
+           ipcprotocol.h
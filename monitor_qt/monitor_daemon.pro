@@ -0,0 +1,14 @@
+QT       = core network concurrent
+TARGET = monitor_daemon
+TEMPLATE = app
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+OBJECTS_DIR = .obj/daemon
+MOC_DIR = .moc/daemon
+
+# Lõi tĩnh + Edge Impulse (libcurl, tflite) + zlib (nén file log) + libmosquitto (MQTT)
+LIBS += -L$$OUT_PWD -lmonitor_core -lcurl -ltensorflow-lite -lz -lmosquitto -ldl -latomic
+PRE_TARGETDEPS += $$OUT_PWD/libmonitor_core.a
+
+SOURCES += main_daemon.cpp
@@ -9,11 +9,16 @@ MONITOR_QT_SITE = package/monitor_qt
 MONITOR_QT_SITE_METHOD = local
 
 # Khai báo các thư viện phụ thuộc để Buildroot build chúng trước
-MONITOR_QT_DEPENDENCIES = qt5base libcurl tensorflow-lite
+MONITOR_QT_DEPENDENCIES = qt5base libcurl tensorflow-lite zlib mosquitto
 
-# Bước 1: Cấu hình (Chạy qmake)
+# Tuỳ chọn: chỉ link các kernel TFLite mà impulse dùng
+ifeq ($(BR2_PACKAGE_MONITOR_QT_STATIC_OPS),y)
+MONITOR_QT_QMAKE_OPTS += CONFIG+=tflite_static_ops
+endif
+
+# Bước 1: Cấu hình (Chạy qmake: lõi, daemon và giao diện)
 define MONITOR_QT_CONFIGURE_CMDS
-    (cd $(@D); $(QT5_QMAKE) monitor_app.pro)
+    (cd $(@D); $(QT5_QMAKE) monitor.pro $(MONITOR_QT_QMAKE_OPTS))
 endef
 
 # Bước 2: Build (Chạy make)
@@ -24,6 +29,16 @@ endef
 # Bước 3: Cài đặt vào Target (Copy file chạy vào /usr/bin)
 define MONITOR_QT_INSTALL_TARGET_CMDS
     $(INSTALL) -D -m 0755 $(@D)/monitor_app_qt $(TARGET_DIR)/usr/bin/monitor_app_qt
+    $(INSTALL) -D -m 0755 $(@D)/monitor_daemon $(TARGET_DIR)/usr/bin/monitor_daemon
+    $(INSTALL) -D -m 0755 $(@D)/bench_features $(TARGET_DIR)/usr/bin/bench_features
+    $(INSTALL) -D -m 0755 $(@D)/telemetry_spool_test.sh $(TARGET_DIR)/usr/bin/telemetry_spool_test.sh
+    $(INSTALL) -D -m 0644 $(@D)/monitor_zones.conf $(TARGET_DIR)/etc/monitor_zones.conf
+    $(INSTALL) -D -m 0644 $(@D)/monitor_sim.conf $(TARGET_DIR)/etc/monitor_sim.conf
+endef
+
+# Script tự động chạy daemon khi boot (giao diện có thể khởi động lại độc lập)
+define MONITOR_QT_INSTALL_INIT_SYSV
+    $(INSTALL) -D -m 0755 $(MONITOR_QT_PKGDIR)/S97monitor_core $(TARGET_DIR)/etc/init.d/S97monitor_core
 endef
 
 $(eval $(generic-package))
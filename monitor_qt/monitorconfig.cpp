@@ -0,0 +1,86 @@
+#include "monitorconfig.h"
+#include <QDebug>
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+#include <QRegExp>
+
+bool AcquisitionConfig::set(const QString &key, const QString &value) {
+    if (key == "dht11_period_ms") { if (value.toInt() > 0) dhtPeriodMs = value.toInt(); }
+    else if (key == "bh1750_period_ms") { if (value.toInt() > 0) bhPeriodMs = value.toInt(); }
+    else if (key == "decimation") mode = (value == "mean") ? DECIMATE_MEAN_REJECT : DECIMATE_MEDIAN;
+    else if (key == "realtime") realtime = (value == "1" || value == "on");
+    else if (key == "rt_cpu") rtCpu = value.toInt();
+    else if (key == "rt_priority") { if (value.toInt() >= 1 && value.toInt() <= 99) rtPriority = value.toInt(); }
+    else return false;
+    return true;
+}
+
+bool StorageConfig::set(const QString &key, const QString &value) {
+    if (key == "compress") compress = value.toInt() != 0;
+    else if (key == "retention_mb") { if (value.toInt() >= 0) retentionMb = value.toInt(); }
+    else if (key == "retention_days") { if (value.toInt() >= 0) retentionDays = value.toInt(); }
+    else return false;
+    return true;
+}
+
+bool ShadowConfig::set(const QString &key, const QString &value) {
+    if (key == "shadow_minutes") { if (value.toInt() >= 0) minutes = value.toInt(); }
+    else if (key == "shadow_min_windows") { if (value.toInt() >= 0) minWindows = value.toInt(); }
+    else if (key == "shadow_max_latency_ratio") { if (value.toFloat() >= 0) maxLatencyRatio = value.toFloat(); }
+    else if (key == "shadow_max_latency_ms") { if (value.toFloat() >= 0) maxLatencyMs = value.toFloat(); }
+    else if (key == "shadow_min_agreement") { if (value.toFloat() >= 0) minAgreement = value.toFloat(); }
+    else if (key == "shadow_max_memory_kb") { if (value.toInt() >= 0) maxMemoryKb = value.toInt(); }
+    else return false;
+    return true;
+}
+
+bool TrainingConfig::set(const QString &key, const QString &value) {
+    if (key == "training") local = (value != "cloud");
+    else if (key == "train_epochs") { if (value.toInt() > 0) epochs = value.toInt(); }
+    else if (key == "train_learning_rate") { if (value.toFloat() > 0) learningRate = value.toFloat(); }
+    else if (key == "train_stride") { if (value.toInt() > 0) stride = value.toInt(); }
+    else if (key == "train_min_class_windows") { if (value.toInt() >= 0) minClassWindows = value.toInt(); }
+    else if (key == "train_validation") { if (value.toFloat() >= 0 && value.toFloat() < 1) validation = value.toFloat(); }
+    else return false;
+    return true;
+}
+
+bool PublishConfig::set(const QString &key, const QString &value) {
+    if (key == "mqtt_host") host = value;
+    else if (key == "mqtt_port") { if (value.toInt() > 0) port = value.toInt(); }
+    else if (key == "mqtt_topic") topic = value;
+    else if (key == "mqtt_user") user = value;
+    else if (key == "mqtt_password") password = value;
+    else if (key == "mqtt_publish_s") { if (value.toInt() > 0) intervalS = value.toInt(); }
+    else if (key == "mqtt_spool_kb") { if (value.toInt() > 0) spoolKb = value.toInt(); }
+    else if (key == "mqtt_drain_per_s") { if (value.toInt() > 0) drainPerS = value.toInt(); }
+    else return false;
+    return true;
+}
+
+// Format: one zone per line "name dht_dev bh_dev", '#' starts a comment, settings as "key=value"
+MonitorConfig MonitorConfig::load(const QString &path, const QString &baseDataDir, const QString &defaultDht, const QString &defaultBh) {
+    MonitorConfig config;
+    QFile file(path);
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream in(&file);
+        while (!in.atEnd()) {
+            QString line = in.readLine().section('#', 0, 0).trimmed();
+            if (line.isEmpty()) continue;
+            if (line.contains('=')) {
+                QString key = line.section('=', 0, 0).trimmed(); QString value = line.section('=', 1).trimmed();
+                if (!config.acq.set(key, value) && !config.storage.set(key, value) && !config.shadow.set(key, value) &&
+                    !config.training.set(key, value) && !config.publish.set(key, value)) qDebug() << "Zone config: unknown setting" << line;
+                continue;
+            }
+            QStringList parts = line.split(QRegExp("\\s+"));
+            if (parts.size() < 3) { qDebug() << "Zone config: skipping line" << line; continue; }
+            ZoneConfig z; z.name = parts[0]; z.dhtDev = parts[1]; z.bhDev = parts[2];
+            z.dataDir = config.zones.isEmpty() ? baseDataDir : QString("%1/%2").arg(baseDataDir).arg(z.name);
+            config.zones.append(z);
+        }
+    }
+    if (config.zones.isEmpty()) { ZoneConfig z; z.name = "Zone 1"; z.dhtDev = defaultDht; z.bhDev = defaultBh; z.dataDir = baseDataDir; config.zones.append(z); }
+    return config;
+}
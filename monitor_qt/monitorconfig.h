@@ -0,0 +1,138 @@
+#ifndef MONITORCONFIG_H
+#define MONITORCONFIG_H
+
+#include <QString>
+#include <QList>
+
+#include "decimator.h"   // DecimationMode
+
+#define ZONES_CONF_FILE "/etc/monitor_zones.conf"
+
+// Default sensor sampling periods, decimated to one value per model tick
+#define DHT11_PERIOD_MS  2000
+#define BH1750_PERIOD_MS 1000
+
+// Real-time acquisition (RealtimeSampler): SCHED_FIFO priority of the sensor thread
+#define RT_PRIORITY 80
+
+// Default log storage budget (LogCompactor)
+#define RETENTION_MB   512
+#define RETENTION_DAYS 0
+
+// Default shadow evaluation of a downloaded model before it replaces the live one
+#define SHADOW_MINUTES           60
+#define SHADOW_MIN_WINDOWS       100
+#define SHADOW_MAX_LATENCY_RATIO 1.5
+#define SHADOW_MIN_AGREEMENT     0.8
+
+// Default on-device head training
+#define TRAIN_EPOCHS            40
+#define TRAIN_LEARNING_RATE     0.05
+#define TRAIN_STRIDE            6
+#define TRAIN_MIN_CLASS_WINDOWS 20
+#define TRAIN_VALIDATION        0.2
+
+// Default live telemetry (TelemetryPublisher), off unless mqtt_host is set
+#define MQTT_PORT        1883
+#define MQTT_PUBLISH_S   30
+#define MQTT_SPOOL_KB    4096
+#define MQTT_DRAIN_PER_S 5
+
+// Everything below comes from the zones config file (ZONES_CONF_FILE): one zone
+// per line, global settings as "key=value" lines. Each settings struct takes
+// its own keys in set(); false if the key is not one of them.
+
+// One room: sensor nodes + folder where its daily CSV files go.
+// Device strings pick the SensorSource backend: a /dev node (chardev driver), "auto",
+// "iio:<name>", "replay:<log>", or "sim" / "sim:<profile>" for a synthetic profile.
+struct ZoneConfig {
+    QString name;
+    QString dhtDev;
+    QString bhDev;
+    QString dataDir;
+};
+
+// Sampling: "dht11_period_ms", "bh1750_period_ms", "decimation=median|mean",
+// "realtime=0|1", "rt_cpu", "rt_priority"
+struct AcquisitionConfig {
+    int dhtPeriodMs = DHT11_PERIOD_MS;
+    int bhPeriodMs = BH1750_PERIOD_MS;
+    DecimationMode mode = DECIMATE_MEDIAN;
+    // Sensor reads on a SCHED_FIFO thread pinned to rtCpu (-1: last core), memory locked
+    bool realtime = false;
+    int rtCpu = -1;
+    int rtPriority = RT_PRIORITY;
+
+    bool set(const QString &key, const QString &value);
+};
+
+// Day file compaction and retention (LogCompactor): "compress", "retention_mb",
+// "retention_days". 0 disables a limit.
+struct StorageConfig {
+    bool compress = true;
+    int retentionMb = RETENTION_MB;
+    int retentionDays = RETENTION_DAYS;
+
+    bool set(const QString &key, const QString &value);
+};
+
+// Promotion gate for a candidate model (ShadowEvaluator): "shadow_minutes",
+// "shadow_min_windows", "shadow_max_latency_ratio", "shadow_max_latency_ms",
+// "shadow_min_agreement", "shadow_max_memory_kb". 0 disables a limit.
+struct ShadowConfig {
+    int minutes = SHADOW_MINUTES;              // evaluation period
+    int minWindows = SHADOW_MIN_WINDOWS;       // and at least this many compared windows
+    float maxLatencyRatio = SHADOW_MAX_LATENCY_RATIO;   // candidate p95 / live p95
+    float maxLatencyMs = 0;                    // absolute p95 limit
+    float minAgreement = SHADOW_MIN_AGREEMENT; // same top label as the live model
+    int maxMemoryKb = 0;                       // RSS growth when loading the candidate
+
+    bool set(const QString &key, const QString &value);
+};
+
+// Model refresh: fine-tune the classifier head on the device (HeadTrainer) and
+// fall back to the cloud retrain/build/download if that fails. "training=local|cloud",
+// "train_epochs", "train_learning_rate", "train_stride", "train_min_class_windows",
+// "train_validation".
+struct TrainingConfig {
+    bool local = true;
+    int epochs = TRAIN_EPOCHS;
+    float learningRate = TRAIN_LEARNING_RATE;
+    int stride = TRAIN_STRIDE;                  // normal windows: one every N samples
+    int minClassWindows = TRAIN_MIN_CLASS_WINDOWS;
+    float validation = TRAIN_VALIDATION;        // held-out tail of each zone's history
+
+    bool set(const QString &key, const QString &value);
+};
+
+// Live telemetry to an MQTT broker (TelemetryPublisher): "mqtt_host", "mqtt_port",
+// "mqtt_topic", "mqtt_user", "mqtt_password", "mqtt_publish_s", "mqtt_spool_kb",
+// "mqtt_drain_per_s"
+struct PublishConfig {
+    QString host;                       // empty: publisher off
+    int port = MQTT_PORT;
+    QString topic;                      // empty: monitor/<hostname>
+    QString user;
+    QString password;
+    int intervalS = MQTT_PUBLISH_S;     // one batch payload per interval (events flush at once)
+    int spoolKb = MQTT_SPOOL_KB;        // offline queue on disk, oldest dropped beyond this
+    int drainPerS = MQTT_DRAIN_PER_S;   // spooled payloads sent per second once back online
+
+    bool set(const QString &key, const QString &value);
+};
+
+// The whole zones config file
+struct MonitorConfig {
+    QList<ZoneConfig> zones;
+    AcquisitionConfig acq;
+    StorageConfig storage;
+    ShadowConfig shadow;
+    TrainingConfig training;
+    PublishConfig publish;
+
+    // Zone 0 logs to baseDataDir (keeps the upload layout), others to baseDataDir/<name>.
+    // No zone line (or no file): one zone with the default devices.
+    static MonitorConfig load(const QString &path, const QString &baseDataDir, const QString &defaultDht, const QString &defaultBh);
+};
+
+#endif // MONITORCONFIG_H
@@ -0,0 +1,536 @@
+#include "monitorcore.h"
+#include "virtualclock.h"
+#include "opresolver.h"
+#include "headtrainer.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QtConcurrent/QtConcurrent>
+#include <QProcess>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonValue>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QDir>
+#include <QStringList>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QThreadPool>
+
+// C System Headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <math.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <errno.h>
+#include <float.h>
+#include <string.h>
+#include <algorithm>
+
+// --- CONFIG ---
+#define DATA_DIR        "/mnt/data"
+#define UPLOAD_MARKER   "/mnt/data/.last_upload_date"
+#define MODEL_FILE      "/mnt/data/model.tflite"
+#define CANDIDATE_FILE  "/mnt/data/model_candidate.tflite"
+#define SHADOW_REPORT   "/mnt/data/shadow_report.json"
+#define TRAIN_REPORT    "/mnt/data/train_report.json"
+#define ACQ_REPORT      "/mnt/data/acq_latency.json"
+#define ZIP_FILE        "/mnt/data/model_download.zip"
+#define EXTRACT_DIR     "/mnt/data/model_temp_extract"
+#define WIFI_IFACE      "wlan0"
+// Thay th? b?ng API Key th?t c?a b?n n?u c?n
+#define EI_API_KEY      "ei_938352ab999f8f68e87a537d008fc05e944ef77b9589338f8f525fcd74f3c47d"
+#define PROJECT_ID      "855133"
+
+#define UPLOAD_URL      "https://ingestion.edgeimpulse.com/api/training/files"
+#define RETRAIN_URL     "https://studio.edgeimpulse.com/v1/api/" PROJECT_ID "/jobs/retrain?impulseId=3"
+#define BUILD_URL       "https://studio.edgeimpulse.com/v1/api/" PROJECT_ID "/jobs/build-ondevice-model?type=custom&impulseId=3"
+#define JOB_STATUS_URL  "https://studio.edgeimpulse.com/v1/api/" PROJECT_ID "/jobs/%d/status"
+#define BASE_DOWNLOAD_URL "https://studio.edgeimpulse.com/v1/api/" PROJECT_ID "/deployment/download"
+#define DOWNLOAD_QUERY  "?type=custom&modelType=int8&engine=tflite&impulseId=3"
+
+const char* LABELS_TEXT[] = {"Normal", "Temp Inc, Humid Dec", "Temp Inc, Humid Inc"};
+
+// --- HELPERS ---
+struct MemoryStruct { char *memory; size_t size; };
+static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb, void *userp) {
+  size_t realsize = size * nmemb; struct MemoryStruct *mem = (struct MemoryStruct *)userp;
+  char *ptr = (char*)realloc(mem->memory, mem->size + realsize + 1); if(!ptr) return 0;
+  mem->memory = ptr; memcpy(&(mem->memory[mem->size]), contents, realsize); mem->size += realsize; mem->memory[mem->size] = 0; return realsize;
+}
+static size_t WriteFileCallback(void *ptr, size_t size, size_t nmemb, void *stream) { return fwrite(ptr, size, nmemb, (FILE *)stream); }
+static int parse_job_id(const char* json_str) {
+    const char *ptr = strstr(json_str, "\"id\""); if (!ptr) return -1; ptr += 4; while (*ptr == ':' || *ptr == ' ' || *ptr == '"') ptr++;
+    int id = -1; if (sscanf(ptr, "%d", &id) == 1) return id; return -1;
+}
+
+// ============================================================================
+//  MONITOR CORE
+// ============================================================================
+
+MonitorCore::MonitorCore(QObject *parent) : QObject(parent)
+{
+    curl_global_init(CURL_GLOBAL_ALL);
+    (void)system("modprobe dht11_driver"); (void)system("modprobe bh1750_driver");
+    struct stat st = {0}; if (stat(DATA_DIR, &st) == -1) mkdir(DATA_DIR, 0700);
+
+    // Zones (MONITOR_ZONES overrides the config file, e.g. for simulated zones;
+    // MONITOR_DATA_DIR moves the zone logs, e.g. for a soak run off the target)
+    QString zonesConf = qEnvironmentVariableIsSet("MONITOR_ZONES") ? qEnvironmentVariable("MONITOR_ZONES") : QString(ZONES_CONF_FILE);
+    QString dataDir = qEnvironmentVariableIsSet("MONITOR_DATA_DIR") ? qEnvironmentVariable("MONITOR_DATA_DIR") : QString(DATA_DIR); QDir().mkpath(dataDir);
+    cfg = MonitorConfig::load(zonesConf, dataDir, AUTO_DEVICE, AUTO_DEVICE);
+    for (int i = 0; i < cfg.zones.size(); i++) { zones.append(new ZonePipeline(cfg.zones[i], i)); zones.last()->setDecimationMode(cfg.acq.mode); }
+
+    isSystemReady = false; start_time = 0;
+    statusText = "Please Connect Wifi or Set Time";
+    lastWifiState = "UNKNOWN";
+}
+
+MonitorCore::~MonitorCore() { sampler.reset(); if (publisher) publisher->stop(); if (compactor) compactor->stop(); qDeleteAll(zones); curl_global_cleanup(); }
+
+// Called once the IPC server is listening, so clients see the startup messages
+void MonitorCore::start() {
+    loadModel();
+
+    // Sensors are oversampled at their own rates, onTimerTick() decimates to the model cadence.
+    // Periods are in virtual time, so a --speed run scales the whole loop.
+    // realtime=1: a SCHED_FIFO thread on its own core does the reads instead of these timers.
+    if (cfg.acq.realtime && !VirtualClock::isVirtual()) startRealtime();
+    acqClock.start();
+    dhtTimer = new QTimer(this); dhtTimer->setTimerType(Qt::PreciseTimer); connect(dhtTimer, &QTimer::timeout, this, &MonitorCore::onDHT11Tick);
+    bhTimer = new QTimer(this); bhTimer->setTimerType(Qt::PreciseTimer); connect(bhTimer, &QTimer::timeout, this, &MonitorCore::onBH1750Tick);
+    if (!sampler) { dhtTimer->start(VirtualClock::interval(cfg.acq.dhtPeriodMs)); bhTimer->start(VirtualClock::interval(cfg.acq.bhPeriodMs)); }
+    timer = new QTimer(this); timer->setTimerType(Qt::PreciseTimer); connect(timer, &QTimer::timeout, this, &MonitorCore::onTimerTick); timer->start(VirtualClock::interval(INTERVAL_S * 1000));
+    wifiTimer = new QTimer(this); connect(wifiTimer, &QTimer::timeout, this, &MonitorCore::checkWifiState);
+    // Virtual clock: the time is already set and there is no network to manage
+    if (VirtualClock::isVirtual()) initializeLoggingSession(); else wifiTimer->start(3000);
+
+    // Day file compression + retention in the background
+    QStringList zoneDirs; for (ZonePipeline *zone : zones) zoneDirs.append(zone->config().dataDir);
+    compactor = new LogCompactor(zoneDirs, UPLOAD_MARKER, cfg.storage, this); if (sampler) compactor->setStackSize(RT_POOL_STACK_KB * 1024);
+    connect(compactor, &LogCompactor::unuploadedDeleted, this, [this](const QStringList &days) { emit notify("warning", "Storage Full", QString("Deleted %1 day(s) of logs before upload: %2").arg(days.size()).arg(days.join(", "))); });
+    compactor->start(QThread::IdlePriority);
+
+    // Live telemetry: the signals are handled right here on the loop thread, the publisher only queues
+    // them; packing, MQTT I/O and the offline spool (next to zone 0's logs) are on its own thread
+    if (!cfg.publish.host.isEmpty()) {
+        publisher = new TelemetryPublisher(cfg.publish, zones.first()->config().dataDir + "/mqtt_spool", this);
+        connect(this, &MonitorCore::sampleReady, this, [this](int zone, qint64 ts, float t, float h, float l) { publisher->addSample(zone, ts, t, h, l); }, Qt::DirectConnection);
+        connect(this, &MonitorCore::predictionReady, this, [this](int zone, int label, float prob) { publisher->addPrediction(zone, VirtualClock::now(), label, prob); }, Qt::DirectConnection);
+        connect(this, &MonitorCore::eventDetected, this, [this](int zone, int label, float prob) { publisher->addEvent(zone, VirtualClock::now(), label, prob); }, Qt::DirectConnection);
+        if (sampler) publisher->setStackSize(RT_POOL_STACK_KB * 1024);
+        publisher->start(QThread::LowPriority);
+    }
+    onTimerTick();
+}
+
+QString MonitorCore::status() const { QMutexLocker lock(&statusMutex); return statusText; }
+void MonitorCore::setStatus(const QString &text) { { QMutexLocker lock(&statusMutex); statusText = text; } qDebug() << "Status:" << text; emit statusChanged(text); }
+
+void MonitorCore::initializeLoggingSession() {
+    start_time = VirtualClock::now(); loop_count = 0;
+    for (ZonePipeline *zone : zones) zone->reset();
+    isSystemReady = true;
+    emit sessionChanged(true);
+    setStatus("System Ready. Smart Logging Active.");
+}
+
+void MonitorCore::requestModelUpdate() {
+    if (!isSystemReady) { emit notify("warning", "Not Ready", "Please set system time first!"); return; }
+    setStatus("Starting Update Process..."); lastWifiState = "UPDATING";
+    if (cfg.training.local && interpreter && !shadow) {
+        // Samples still in RAM are only touched on this thread: copy them before handing off
+        QList<QList<BufferedSample>> recent; for (ZonePipeline *zone : zones) recent.append(zone->bufferedSamples());
+        QtConcurrent::run([=]() { if (!this->trainLocally(recent)) this->performUpdateSequence(); });
+        return;
+    }
+    QtConcurrent::run([=]() { this->performUpdateSequence(); });
+}
+
+// Fine-tunes the head of the live model on the zone logs; the result goes through the same shadow gate as a download
+bool MonitorCore::trainLocally(const QList<QList<BufferedSample>> &recent) {
+    setStatus("Training On Device...");
+    HeadTrainer trainer(liveModelPath(), cfg.training);
+    for (int i = 0; i < zones.size(); i++) trainer.addZone(zones[i]->config().dataDir, recent[i]);
+    bool ok = trainer.train(CANDIDATE_FILE);
+    QFile report(TRAIN_REPORT); if (report.open(QIODevice::WriteOnly | QIODevice::Truncate)) report.write(QJsonDocument(trainer.report()).toJson());
+    qDebug() << "On-device training" << (ok ? "succeeded" : "failed:") << trainer.errorString();
+    if (!ok) { setStatus("Local Training Failed, Using Cloud..."); emit notify("info", "Local Training", trainer.errorString() + ". Falling back to cloud retraining."); return false; }
+    installCandidate();
+    return true;
+}
+
+QString MonitorCore::getLastUploadDate() { QFile file(UPLOAD_MARKER); if (file.open(QIODevice::ReadOnly | QIODevice::Text)) { QTextStream in(&file); return in.readAll().trimmed(); } return "1970-01-01"; }
+void MonitorCore::setLastUploadDate(QString dateStr) { QFile file(UPLOAD_MARKER); if (file.open(QIODevice::WriteOnly | QIODevice::Text)) { QTextStream out(&file); out << dateStr; file.close(); } }
+
+
+void MonitorCore::checkWifiState() {
+    QString current = status(); if (current.contains("Uploading") || current.contains("Training") || current.contains("Downloading") || current.contains("Building")) return;
+    QProcess process; process.start("wpa_cli", QStringList() << "-i" << WIFI_IFACE << "status"); process.waitForFinished(); QString output = process.readAllStandardOutput();
+    QString currentState = "DISCONNECTED"; QString ssid = "";
+    if (output.contains("wpa_state=COMPLETED")) { currentState = "CONNECTED"; int idx = output.indexOf("ssid="); if (idx != -1) { int end = output.indexOf("\n", idx); ssid = output.mid(idx + 5, end - (idx + 5)); } }
+    else if (output.contains("wpa_state=SCANNING")) currentState = "SCANNING"; else if (output.contains("wpa_state=ASSOCIATING") || output.contains("wpa_state=4WAY_HANDSHAKE")) currentState = "CONNECTING";
+    if (currentState != lastWifiState) {
+        emit wifiStateChanged(currentState, ssid);
+        if (currentState == "CONNECTED") { setStatus(QString("Wifi Connected: %1").arg(ssid)); if (!isSystemReady) QtConcurrent::run([=](){ syncTimeFromInternet(); }); if (!this->model) { setStatus("Wifi Found. Retrying Model Download..."); QtConcurrent::run([=](){ downloadAndInstallModel(); }); } }
+        else if (currentState == "DISCONNECTED") setStatus("Wifi Disconnected!");
+        else if (currentState == "CONNECTING") setStatus("Wifi Connecting...");
+        lastWifiState = currentState;
+    }
+}
+
+// [BUILD/TRAIN/DOWNLOAD HELPERS]
+int MonitorCore::triggerBuildJob() {
+    CURL *curl; CURLcode res; long http_code = 0; int job_id = -1;
+    struct MemoryStruct chunk; chunk.memory = (char*)malloc(1); chunk.size = 0;
+    const char* json_payload = "{\"engine\": \"tflite\", \"modelType\": \"int8\"}";
+    struct curl_slist *headers = NULL; char api_header[128]; sprintf(api_header, "x-api-key: %s", EI_API_KEY);
+    headers = curl_slist_append(headers, api_header); headers = curl_slist_append(headers, "Content-Type: application/json");
+    curl = curl_easy_init();
+    if(curl) {
+        curl_easy_setopt(curl, CURLOPT_URL, BUILD_URL); curl_easy_setopt(curl, CURLOPT_POST, 1L); curl_easy_setopt(curl, CURLOPT_POSTFIELDS, json_payload); curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback); curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk); curl_easy_setopt(curl, CURLOPT_TIMEOUT, 15L);
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L); curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L); curl_easy_setopt(curl, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
+        res = curl_easy_perform(curl); curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+        if(res == CURLE_OK && http_code == 200) job_id = parse_job_id(chunk.memory);
+        curl_easy_cleanup(curl); curl_slist_free_all(headers); free(chunk.memory);
+    } return job_id;
+}
+bool MonitorCore::waitForJob(int job_id, const QString &jobName) {
+    int job_finished = 0; int seconds_waited = 0; int TIMEOUT_LIMIT = 1800;
+    char job_url[256]; sprintf(job_url, JOB_STATUS_URL, job_id); char api_header[128]; sprintf(api_header, "x-api-key: %s", EI_API_KEY);
+    while(job_finished == 0 && seconds_waited < TIMEOUT_LIMIT) {
+        sleep(5); seconds_waited += 5; if(seconds_waited % 10 == 0) setStatus(QString("%1 running (%2s)...").arg(jobName).arg(seconds_waited));
+        CURL *curl = curl_easy_init();
+        if(curl) {
+            struct MemoryStruct chunk; chunk.memory = (char*)malloc(1); chunk.size = 0; struct curl_slist *headers = NULL; headers = curl_slist_append(headers, api_header);
+            curl_easy_setopt(curl, CURLOPT_URL, job_url); curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers); curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback); curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk);
+            curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L); curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L); curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L); curl_easy_setopt(curl, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
+            CURLcode res = curl_easy_perform(curl); long http_code = 0; curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+            if (res == CURLE_OK && http_code == 200) {
+                QByteArray jsonBytes(chunk.memory); QJsonDocument doc = QJsonDocument::fromJson(jsonBytes); QJsonObject rootObj = doc.object();
+                if (rootObj.contains("job")) { QJsonObject jobObj = rootObj["job"].toObject(); if (jobObj.contains("finished")) { if (jobObj["finishedSuccessful"].toBool() == true) job_finished = 1; else job_finished = -1; } }
+            } free(chunk.memory); curl_easy_cleanup(curl); curl_slist_free_all(headers);
+        } if (job_finished != 0) break;
+    } return (job_finished == 1);
+}
+bool MonitorCore::attemptDownload(int retries) {
+    char clean_cmd[256]; sprintf(clean_cmd, "rm -rf %s %s", ZIP_FILE, EXTRACT_DIR); (void)system(clean_cmd);
+    int attempt = 0; bool success = false; char api_header[128]; sprintf(api_header, "x-api-key: %s", EI_API_KEY);
+    while (attempt < retries && !success) {
+        attempt++; QString statusMsg = QString("Downloading (Attempt %1/%2)...").arg(attempt).arg(retries); setStatus(statusMsg);
+        CURL *curl = curl_easy_init(); long http_code = 0;
+        if(curl) {
+            FILE *fp = fopen(ZIP_FILE, "wb");
+            if(fp) {
+                struct curl_slist *headers = NULL; headers = curl_slist_append(headers, api_header); char full_url[512]; sprintf(full_url, "%s%s", BASE_DOWNLOAD_URL, DOWNLOAD_QUERY);
+                curl_easy_setopt(curl, CURLOPT_URL, full_url); curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers); curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteFileCallback); curl_easy_setopt(curl, CURLOPT_WRITEDATA, fp);
+                curl_easy_setopt(curl, CURLOPT_TIMEOUT, 60L); curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L); curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L); curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L); curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L); curl_easy_setopt(curl, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
+                CURLcode res = curl_easy_perform(curl); curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code); fclose(fp); curl_slist_free_all(headers); if (res == CURLE_OK && http_code == 200) success = true;
+            } curl_easy_cleanup(curl);
+        } if (!success) sleep(2);
+    } return success;
+}
+
+void MonitorCore::performUpdateSequence() {
+    if (!isSystemReady) { emit notify("warning", "Error", "Time not synced yet."); return; }
+    QString currentDateStr = QDateTime::currentDateTime().toString("yyyy-MM-dd"); QString lastUploadDateStr = getLastUploadDate();
+    // Past files of every zone, ordered by date so the upload marker only moves forward
+    QStringList filesToUpload;
+    for (ZonePipeline *zone : zones) {
+        QDir dir(zone->config().dataDir); dir.setNameFilters(LogCompactor::dayFileFilters()); dir.setSorting(QDir::Name);
+        QStringList entryList = dir.entryList();
+        foreach (QString filename, entryList) { QString fileDateStr = filename.section('.', 0, 0); if (fileDateStr > lastUploadDateStr && fileDateStr < currentDateStr) filesToUpload.append(dir.filePath(filename)); }
+    }
+    std::sort(filesToUpload.begin(), filesToUpload.end(), [](const QString &a, const QString &b) { return QFileInfo(a).fileName() < QFileInfo(b).fileName(); });
+    if (filesToUpload.isEmpty()) { setStatus("No past files to upload."); emit notify("info", "Info", "All past data is already uploaded."); return; }
+
+    char api_header[128]; sprintf(api_header, "x-api-key: %s", EI_API_KEY); int max_retries = 5;
+    int fileIdx = 0;
+    for (int f = 0; f < filesToUpload.size(); f++) {
+        QString fullPath = filesToUpload[f]; QString filename = QFileInfo(fullPath).fileName();
+        fileIdx++; QString fileDateStr = filename.section('.', 0, 0); bool upload_ok = false;
+        QByteArray compressedData; if (fullPath.endsWith(COMPRESSED_SUFFIX)) compressedData = LogCompactor::readDayFile(fullPath);
+        for (int attempt = 1; attempt <= max_retries; attempt++) {
+            QString msg = QString("Uploading %1 (%2/%3) - Try %4").arg(filename).arg(fileIdx).arg(filesToUpload.size()).arg(attempt); setStatus(msg);
+            CURL *curl = curl_easy_init(); long http_code = 0; CURLcode res = CURLE_FAILED_INIT;
+            if(curl) {
+                curl_mime *form = curl_mime_init(curl); curl_mimepart *field = curl_mime_addpart(form); curl_mime_name(field, "data");
+                // Compressed days are sent as the original CSV
+                if (compressedData.isEmpty()) curl_mime_filedata(field, fullPath.toStdString().c_str()); else { curl_mime_data(field, compressedData.constData(), compressedData.size()); curl_mime_filename(field, (fileDateStr + ".csv").toStdString().c_str()); }
+                curl_mime_type(field, "text/csv");
+                struct curl_slist *headers = NULL; headers = curl_slist_append(headers, api_header); headers = curl_slist_append(headers, "x-disallow-duplicates: 1"); headers = curl_slist_append(headers, "x-label: normal");
+                curl_easy_setopt(curl, CURLOPT_URL, UPLOAD_URL); curl_easy_setopt(curl, CURLOPT_MIMEPOST, form); curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers); curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L); curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L); curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L); curl_easy_setopt(curl, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
+                res = curl_easy_perform(curl); curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code); curl_easy_cleanup(curl); curl_mime_free(form); curl_slist_free_all(headers);
+            }
+            if(res == CURLE_OK && (http_code == 200 || http_code == 201)) { upload_ok = true; break; } else sleep(2);
+        }
+        // Only mark the date once the files of all zones for that day are uploaded
+        bool lastOfDate = (f + 1 == filesToUpload.size()) || QFileInfo(filesToUpload[f + 1]).fileName().section('.', 0, 0) != fileDateStr;
+        if (upload_ok) { if (lastOfDate) { setLastUploadDate(fileDateStr); compactor->trigger(); } } else { setStatus("Upload Error at " + filename); emit notify("warning", "Error", "Failed to upload " + filename); return; }
+    }
+
+    int job_id = -1;
+    for (int attempt = 1; attempt <= max_retries; attempt++) {
+        setStatus(QString("Triggering Retrain (%1/%2)...").arg(attempt).arg(max_retries));
+        CURL *curl = curl_easy_init(); long http_code = 0; CURLcode res = CURLE_FAILED_INIT;
+        if(curl) {
+            struct MemoryStruct chunk; chunk.memory = (char*)malloc(1); chunk.size = 0; struct curl_slist *headers = NULL; headers = curl_slist_append(headers, api_header); headers = curl_slist_append(headers, "Content-Type: application/json");
+            curl_easy_setopt(curl, CURLOPT_URL, RETRAIN_URL); curl_easy_setopt(curl, CURLOPT_POST, 1L); curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers); curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback); curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk); curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L); curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L); curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L); curl_easy_setopt(curl, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
+            res = curl_easy_perform(curl); curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code); if(res == CURLE_OK && http_code == 200) job_id = parse_job_id(chunk.memory); free(chunk.memory); curl_easy_cleanup(curl); curl_slist_free_all(headers);
+        } if (job_id != -1) break; else sleep(2);
+    }
+    if (job_id == -1) { setStatus("Trigger Failed!"); return; }
+    if (!waitForJob(job_id, "Training")) { setStatus("Training Failed!"); return; }
+    int build_id = -1;
+    for (int attempt = 1; attempt <= max_retries; attempt++) { setStatus(QString("Triggering Build (%1/%2)...").arg(attempt).arg(max_retries)); build_id = triggerBuildJob(); if (build_id != -1) break; else sleep(2); }
+    if (build_id == -1) { setStatus("Build Trigger Failed!"); return; }
+    if (!waitForJob(build_id, "Building")) { setStatus("Build Failed!"); return; }
+    if (attemptDownload(5)) this->installDownloadedModel(); else setStatus("Download Failed!");
+}
+
+void MonitorCore::downloadAndInstallModel() {
+    bool success = attemptDownload(5);
+    if (!success) {
+        setStatus("Cache missing. Re-building...");
+        int build_id = triggerBuildJob(); bool build_ok = (build_id != -1) && waitForJob(build_id, "Emergency Build");
+        if (build_ok) { setStatus("Build OK. Downloading..."); success = attemptDownload(5); }
+        else { setStatus("Recovery Build Failed."); return; }
+    } if (success) this->installDownloadedModel(); else setStatus("Recovery Failed (Network).");
+}
+
+void MonitorCore::installDownloadedModel() {
+    setStatus("Installing Model...");
+    char cmd[512]; sprintf(cmd, "mkdir -p %s", EXTRACT_DIR); (void)system(cmd); sprintf(cmd, "unzip -o %s -d %s > /dev/null", ZIP_FILE, EXTRACT_DIR);
+    if (system(cmd) != 0) { setStatus("Unzip Failed!"); emit notify("warning", "Error", "Downloaded file is corrupted."); return; }
+    sprintf(cmd, "mv %s/trained.tflite %s", EXTRACT_DIR, CANDIDATE_FILE); if(system(cmd) != 0) { sprintf(cmd, "find %s -name '*.tflite' -exec mv {} %s \\; -quit", EXTRACT_DIR, CANDIDATE_FILE); (void)system(cmd); }
+    sprintf(cmd, "rm -rf %s %s", ZIP_FILE, EXTRACT_DIR); (void)system(cmd);
+    installCandidate();
+}
+
+// CANDIDATE_FILE is in place (downloaded or trained here): op list, then shadow evaluation or direct install
+void MonitorCore::installCandidate() {
+    if (!TrimmedOpResolver::writeOpList(CANDIDATE_FILE)) qDebug() << "Could not derive the op list of" << CANDIDATE_FILE;
+    QMetaObject::invokeMethod(this, [=]() {
+        // No live model (first install / recovery): nothing to compare against, install directly
+        if (!this->interpreter) {
+            if (this->promoteCandidate(false)) { setStatus("Model Updated!"); emit notify("info", "Success", "Model updated successfully!"); }
+            else { setStatus("New Model Rejected!"); emit notify("warning", "Model Rejected", "New model could not be loaded."); }
+            return;
+        }
+        this->startShadow();
+    }, Qt::QueuedConnection);
+}
+
+// Candidate runs next to the live model on the same windows; promoted by finishShadow() if it passes the gate
+void MonitorCore::startShadow() {
+    shadow.reset(new ShadowEvaluator(CANDIDATE_FILE, inferenceBatch, cfg.shadow));
+    if (!shadow->isValid()) { QString reason = shadow->errorString(); shadow.reset(); ::remove(CANDIDATE_FILE); ::remove(CANDIDATE_FILE OP_LIST_SUFFIX); setStatus("New Model Rejected!"); emit notify("warning", "Model Rejected", "New model cannot run: " + reason); return; }
+    setStatus(QString("Evaluating New Model (shadow, %1 min)...").arg(cfg.shadow.minutes));
+}
+
+void MonitorCore::finishShadow() {
+    QString reason; bool ok = shadow->passed(&reason);
+    QFile report(SHADOW_REPORT); if (report.open(QIODevice::WriteOnly | QIODevice::Truncate)) report.write(QJsonDocument(shadow->report()).toJson());
+    shadow.reset();
+    qDebug() << "Shadow evaluation" << (ok ? "passed:" : "failed:") << reason;
+    if (!ok) { ::remove(CANDIDATE_FILE); ::remove(CANDIDATE_FILE OP_LIST_SUFFIX); setStatus("New Model Rejected!"); emit notify("warning", "Model Rejected", "Keeping current model: " + reason); return; }
+    if (promoteCandidate(true)) { setStatus("Model Updated!"); emit notify("info", "Success", "Model promoted: " + reason); }
+    else { setStatus("New Model Rejected!"); emit notify("warning", "Model Rejected", "New model failed to load, previous model restored."); }
+}
+
+// rename() keeps the swap atomic; MONITOR_MODEL may be on another filesystem, then QFile copies
+static bool moveFile(const QString &from, const QString &to) {
+    if (::rename(from.toLocal8Bit().constData(), to.toLocal8Bit().constData()) == 0) return true;
+    QFile::remove(to); return QFile::rename(from, to);
+}
+
+// CANDIDATE_FILE (and its op list) becomes the model loadModel() reads, the old one kept as .prev.
+// False if the candidate cannot be installed or loaded; with keepPrevious the old model is then moved back and reloaded.
+bool MonitorCore::promoteCandidate(bool keepPrevious) {
+    QString live = liveModelPath(), prev = live + ".prev";
+    QString liveOps = TrimmedOpResolver::opListPath(live), prevOps = TrimmedOpResolver::opListPath(prev);
+    if (keepPrevious) { moveFile(live, prev); moveFile(liveOps, prevOps); }
+    bool installed = moveFile(CANDIDATE_FILE, live);
+    if (installed) { moveFile(CANDIDATE_FILE OP_LIST_SUFFIX, liveOps); if (loadModel()) return true; }
+    else qDebug() << "Could not install" << CANDIDATE_FILE << "as" << live;
+    if (keepPrevious) {
+        // moveFile() clears the target even when the source is missing, so no candidate op list is left behind
+        qDebug() << "Candidate did not load, restoring" << prev;
+        moveFile(prev, live); moveFile(prevOps, liveOps);
+        loadModel();
+    }
+    ::remove(CANDIDATE_FILE); ::remove(CANDIDATE_FILE OP_LIST_SUFFIX);
+    return false;
+}
+
+void MonitorCore::syncTimeFromInternet() {
+    int max_retries = 5; int attempt = 0; bool success = false;
+    while (attempt < max_retries && !success) {
+        attempt++; if (!status().contains("Uploading")) setStatus(QString("Syncing Time (%1/%2)...").arg(attempt).arg(max_retries));
+        CURL *curl = curl_easy_init();
+        if (curl) {
+            struct MemoryStruct chunk; chunk.memory = (char*)malloc(1); chunk.size = 0;
+            curl_easy_setopt(curl, CURLOPT_URL, "http://worldtimeapi.org/api/timezone/Asia/Ho_Chi_Minh"); curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback); curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk); curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L); curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L); curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L); curl_easy_setopt(curl, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
+            if (curl_easy_perform(curl) == CURLE_OK) {
+                QByteArray jsonBytes(chunk.memory); QJsonDocument doc = QJsonDocument::fromJson(jsonBytes); QJsonObject obj = doc.object();
+                if (obj.contains("unixtime")) { qint64 unixtime = obj["unixtime"].toVariant().toLongLong(); QString cmd = QString("date -s @%1").arg(unixtime); if (system(cmd.toStdString().c_str()) == 0) { QMetaObject::invokeMethod(this, [=](){ initializeLoggingSession(); setStatus("Time Synced & System Started!"); }, Qt::QueuedConnection); success = true; } }
+            } curl_easy_cleanup(curl); free(chunk.memory);
+        } if (!success && attempt < max_retries) sleep(2);
+    } if (!success) setStatus("Net Sync Failed. Please Set Time Manually.");
+}
+
+// Order matters: the affinity of this thread is inherited by every thread created after it
+// (thread pool, compactor), and mlockall(MCL_FUTURE) locks their whole stacks, so shrink those first
+void MonitorCore::startRealtime() {
+    QString info;
+    sampler.reset(new RealtimeSampler(zones, cfg.acq, &dhtStats, &bhStats));
+    if (!RealtimeSampler::confineToOtherCores(sampler->cpu(), &info)) qWarning() << "Real-time: not isolating CPU" << sampler->cpu() << "-" << info;
+    QThreadPool::globalInstance()->setStackSize(RT_POOL_STACK_KB * 1024);
+    if (!RealtimeSampler::lockMemory(&info)) qWarning() << "Real-time:" << info;
+    if (!sampler->start(&info)) { qWarning() << "Real-time:" << info << "- using timers"; sampler.reset(); return; }
+    for (ZonePipeline *zone : zones) zone->setFallbackReads(false);
+    qInfo().noquote() << "Real-time acquisition:" << info;
+}
+
+void MonitorCore::onDHT11Tick() { sampleTimed(true); }
+void MonitorCore::onBH1750Tick() { sampleTimed(false); }
+
+// Timer mode: same per-read statistics as RealtimeSampler, deadlines advance by one timer period
+void MonitorCore::sampleTimed(bool dht) {
+    time_t now = VirtualClock::now(); qint64 period = (qint64)VirtualClock::interval(dht ? cfg.acq.dhtPeriodMs : cfg.acq.bhPeriodMs) * 1000000LL;
+    qint64 &deadline = dht ? dhtDeadlineNs : bhDeadlineNs; deadline += period;
+    for (ZonePipeline *zone : zones) {
+        qint64 begin = acqClock.nsecsElapsed();
+        bool ok = dht ? zone->sampleDHT11(now) : zone->sampleBH1750(now);
+        qint64 end = acqClock.nsecsElapsed();
+        (dht ? dhtStats : bhStats).record((begin - deadline) / 1000.0, (end - begin) / 1000.0, ok);
+    }
+    // Qt drops missed timeouts instead of queueing them: resync rather than report ever-growing lateness
+    qint64 t = acqClock.nsecsElapsed(); if (t - deadline > period) deadline += ((t - deadline) / period) * period;
+}
+
+void MonitorCore::reportReadStats() {
+    QString mode = sampler ? QString("realtime (CPU %1)").arg(sampler->cpu()) : QString("timers");
+    qInfo().noquote() << "Sensor reads," << mode << "-" << dhtStats.summary("DHT11");
+    qInfo().noquote() << "Sensor reads," << mode << "-" << bhStats.summary("BH1750");
+    // Sensor HAL backend of each zone and what a read() costs there
+    QJsonArray backends;
+    for (ZonePipeline *zone : zones) {
+        for (const SensorSource *src : {zone->dhtSensor(), zone->bhSensor()}) {
+            const char *sensor = src == zone->dhtSensor() ? "dht11" : "bh1750";
+            qInfo().noquote() << "Sensor backend," << zone->config().name << sensor << "-" << src->costSummary();
+            backends.append(QJsonObject{{"zone", zone->config().name}, {"sensor", sensor}, {"backend", src->backend()},
+                                        {"us_per_read", src->cost().usPerRead()}, {"us_per_sample", src->cost().usPerSample()},
+                                        {"reads", (qint64)src->cost().calls}, {"samples", (qint64)src->cost().samples}, {"failures", (qint64)src->cost().failures}});
+        }
+    }
+    QJsonObject report{{"mode", sampler ? "realtime" : "timers"}, {"time", (qint64)VirtualClock::now()}, {"dht11", dhtStats.toJson()}, {"bh1750", bhStats.toJson()}, {"backends", backends}};
+    if (sampler) report["cpu"] = sampler->cpu();
+    QFile file(ACQ_REPORT); if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) file.write(QJsonDocument(report).toJson());
+}
+
+void MonitorCore::onTimerTick() {
+    // 1. DECIMATE SENSOR SAMPLES
+    time_t now = VirtualClock::now();
+    for (int z = 0; z < zones.size(); z++) {
+        ZonePipeline *zone = zones[z]; zone->decimate(now);
+        emit sampleReady(z, (qint64)now, zone->temp(), zone->humid(), zone->lux());
+    }
+    if (++statsTicks % (READ_STATS_REPORT_MIN * 60 / INTERVAL_S) == 0) reportReadStats();
+
+    if (!isSystemReady) return;
+
+    // 2-4. BUFFER, DETECT EVENTS, FLUSH TO DISK, ROLLUPS
+    bool anyReady = false;
+    for (int z = 0; z < zones.size(); z++) {
+        zones[z]->record(now);
+        int closed = zones[z]->rollups().addSample(now, zones[z]->temp(), zones[z]->humid(), zones[z]->lux());
+        for (int t = 0; t < ROLLUP_TIERS; t++) if (closed & (1 << t)) emit rollupClosed(z, t, zones[z]->rollups().lastClosed(t));
+        if (zones[z]->isWindowReady()) anyReady = true;
+        else emit bufferingProgress(z, zones[z]->samplesCollected());
+    }
+
+    // 5. INFERENCE
+    if (anyReady) runInference();
+    loop_count++;
+}
+
+// MONITOR_MODEL: model file for bench/soak runs instead of MODEL_FILE; updates are installed there too
+QString MonitorCore::liveModelPath() { return qEnvironmentVariableIsSet("MONITOR_MODEL") ? QString::fromLocal8Bit(qgetenv("MONITOR_MODEL")) : QString(MODEL_FILE); }
+
+bool MonitorCore::loadModel() {
+    QByteArray modelPath = liveModelPath().toLocal8Bit();
+    model.reset(); interpreter.reset();
+    long rssBefore = ShadowEvaluator::residentKb(); QElapsedTimer loadTimer; loadTimer.start();
+    model = tflite::FlatBufferModel::BuildFromFile(modelPath.constData());
+    if (!model) { qDebug() << "ERROR: Model missing..."; setStatus("Model Error! Recovering..."); static bool is_recovering = false; if (!is_recovering) { is_recovering = true; QtConcurrent::run([=](){ downloadAndInstallModel(); is_recovering = false; }); } return false; }
+    // Only the kernels listed in <model>.ops (written at install time) get registered
+    QString resolverInfo; std::unique_ptr<tflite::OpResolver> resolver = TrimmedOpResolver::create(QString::fromLocal8Bit(modelPath), *model, &resolverInfo);
+    tflite::InterpreterBuilder builder(*model, *resolver); builder(&interpreter);
+    if (!interpreter) {
+        // Trimmed set short of a kernel after all: one retry with every builtin rather than no classifier
+        std::unique_ptr<tflite::OpResolver> full = TrimmedOpResolver::fullResolver();
+        qDebug() << "Interpreter build failed with" << resolverInfo << (full ? "- retrying with the full builtin resolver" : "");
+        if (full) { resolver = std::move(full); resolverInfo = "full builtin resolver (trimmed build failed)"; tflite::InterpreterBuilder retry(*model, *resolver); retry(&interpreter); }
+    }
+    if (!interpreter) { qDebug() << "Interpreter build failed with" << resolverInfo; setStatus("Failed to construct interpreter!"); return false; }
+    // Resize the batch dimension so all zones go through a single Invoke()
+    inferenceBatch = 1;
+    if (zones.size() > 1) {
+        int input_idx = interpreter->inputs()[0];
+        if (interpreter->ResizeInputTensor(input_idx, {(int)zones.size(), MODEL_INPUT_COUNT}) == kTfLiteOk && interpreter->AllocateTensors() == kTfLiteOk) inferenceBatch = zones.size();
+        else { qDebug() << "Model batch resize failed, running zones one by one"; interpreter->ResizeInputTensor(input_idx, {1, MODEL_INPUT_COUNT}); }
+    }
+    if (interpreter->AllocateTensors() != kTfLiteOk) { interpreter.reset(); setStatus("Tensor Alloc Failed!"); return false; }
+    long rssAfter = ShadowEvaluator::residentKb();
+    qInfo().noquote() << QString("Model loaded in %1 ms (%2), RSS %3 -> %4 kB (+%5 kB)").arg(loadTimer.nsecsElapsed() / 1e6, 0, 'f', 1).arg(resolverInfo).arg(rssBefore).arg(rssAfter).arg(rssAfter - rssBefore);
+    qDebug() << "Model Loaded Successfully"; setStatus("Model Loaded.");
+    return true;
+}
+
+void MonitorCore::runInference() {
+    if (!interpreter) return;
+    int input_idx = interpreter->inputs()[0]; TfLiteTensor* input_tensor = interpreter->tensor(input_idx);
+    int output_idx = interpreter->outputs()[0]; TfLiteTensor* output_tensor = interpreter->tensor(output_idx);
+
+    for (int first = 0; first < zones.size(); first += inferenceBatch) {
+        int count = qMin(inferenceBatch, zones.size() - first);
+        // Pack each zone's window into its row of the batch (zones still buffering get zeros)
+        QVector<float> processed_input(MODEL_INPUT_COUNT * count);
+        for (int b = 0; b < count; b++) {
+            if (zones[first + b]->isWindowReady()) zones[first + b]->computeFeatures(&processed_input[b * MODEL_INPUT_COUNT]);
+        }
+        int total_inputs = MODEL_INPUT_COUNT * count;
+        if (input_tensor->type == kTfLiteInt8) quantizeInt8(processed_input.constData(), total_inputs, input_tensor->params.scale, input_tensor->params.zero_point, interpreter->typed_input_tensor<int8_t>(0));
+        else { float* input_data = interpreter->typed_input_tensor<float>(0); for(int i=0; i<total_inputs; i++) input_data[i] = processed_input[i]; }
+        QElapsedTimer invokeTimer; invokeTimer.start();
+        if (interpreter->Invoke() != kTfLiteOk) { setStatus("Inference Failed!"); return; }
+        double liveMs = invokeTimer.nsecsElapsed() / 1e6;
+
+        QVector<int> liveLabels(count, -1);
+        for (int b = 0; b < count; b++) {
+            ZonePipeline *zone = zones[first + b]; if (!zone->isWindowReady()) continue;
+            float probs[NUM_LABELS];
+            if (output_tensor->type == kTfLiteInt8) { float scale = output_tensor->params.scale; int32_t zero_point = output_tensor->params.zero_point; int8_t* out_data = interpreter->typed_output_tensor<int8_t>(0) + b * NUM_LABELS; for(int i=0; i<NUM_LABELS; i++) probs[i] = (out_data[i] - zero_point) * scale; }
+            else { float* out_data = interpreter->typed_output_tensor<float>(0) + b * NUM_LABELS; for(int i=0; i<NUM_LABELS; i++) probs[i] = out_data[i]; }
+            int max_idx = 0; for(int i=1; i<NUM_LABELS; i++) if(probs[i] > probs[max_idx]) max_idx = i;
+            liveLabels[b] = max_idx;
+            emit predictionReady(first + b, max_idx, probs[max_idx]);
+
+            if (max_idx != 0 && zone->lastPredictionIdx == 0) {
+                if (probs[max_idx] > 0.6) emit eventDetected(first + b, max_idx, probs[max_idx]);
+            }
+            zone->lastPredictionIdx = max_idx;
+        }
+        // Shadow candidate on the exact same input rows, after the live result is out
+        if (shadow) shadow->evaluate(processed_input.constData(), count, liveLabels.constData(), liveMs);
+    }
+    if (shadow && shadow->isFinished(VirtualClock::now())) finishShadow();
+}
@@ -0,0 +1,126 @@
+#ifndef MONITORCORE_H
+#define MONITORCORE_H
+
+#include <QObject>
+#include <QTimer>
+#include <QMutex>
+#include <QList>
+#include <QElapsedTimer>
+#include <curl/curl.h>
+#include <memory>
+
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/model.h"
+
+#include "zonepipeline.h"
+#include "logcompactor.h"
+#include "shadowevaluator.h"
+#include "realtimesampler.h"
+#include "telemetrypublisher.h"
+
+#define INTERVAL_S 10
+#define NUM_LABELS 3
+
+extern const char* LABELS_TEXT[];
+
+// GUI-free monitoring core: sensors, features, event labeling, CSV logging,
+// TFLite inference, uploads and training jobs. Runs in monitor_daemon;
+// the kiosk UI only sees the signals below, forwarded by IpcServer.
+class MonitorCore : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MonitorCore(QObject *parent = nullptr);
+    ~MonitorCore();
+
+    void start();
+    const QList<ZonePipeline*> &zoneList() const { return zones; }
+    bool systemReady() const { return isSystemReady; }
+    QString status() const;
+
+public slots:
+    void initializeLoggingSession();
+    void requestModelUpdate();
+
+signals:
+    void sampleReady(int zone, qint64 timestamp, float temp, float hum, float lux);
+    void bufferingProgress(int zone, int collected);
+    void rollupClosed(int zone, int tier, const RollupBucket &bucket);
+    void predictionReady(int zone, int labelIdx, float prob);
+    void eventDetected(int zone, int labelIdx, float prob);
+    void statusChanged(const QString &text);
+    void sessionChanged(bool ready);
+    void wifiStateChanged(const QString &state, const QString &ssid);
+    void notify(const QString &level, const QString &title, const QString &text);
+
+private slots:
+    void onTimerTick();
+    void onDHT11Tick();
+    void onBH1750Tick();
+    void checkWifiState();
+
+private:
+    // System
+    QTimer *timer;
+    QTimer *dhtTimer;
+    QTimer *bhTimer;
+    QTimer *wifiTimer;
+    QString lastWifiState;
+    time_t start_time;
+    int loop_count = 0;
+
+    // Sensor read timing (both modes); sampler is set in real-time mode and replaces dhtTimer/bhTimer
+    ReadStats dhtStats, bhStats;
+    std::unique_ptr<RealtimeSampler> sampler;
+    QElapsedTimer acqClock;
+    qint64 dhtDeadlineNs = 0, bhDeadlineNs = 0;
+    int statsTicks = 0;
+    bool isSystemReady = false;
+
+    // Last status text, written from worker threads too
+    mutable QMutex statusMutex;
+    QString statusText;
+    void setStatus(const QString &text);
+
+    // AI Model
+    std::unique_ptr<tflite::FlatBufferModel> model;
+    std::unique_ptr<tflite::Interpreter> interpreter;
+    int inferenceBatch = 1; // Zones packed per Invoke(), 1 if the model cannot be resized
+    std::unique_ptr<ShadowEvaluator> shadow; // Downloaded or locally trained candidate under evaluation, null otherwise
+
+    // Zones config file: zones, sampling, storage, shadow, training and telemetry settings
+    MonitorConfig cfg;
+
+    // Zones
+    QList<ZonePipeline*> zones;
+    LogCompactor *compactor = nullptr;
+    TelemetryPublisher *publisher = nullptr;
+
+    // Functions
+    void syncTimeFromInternet();
+    QString getLastUploadDate();
+    void setLastUploadDate(QString dateStr);
+
+    void startRealtime();
+    void sampleTimed(bool dht);
+    void reportReadStats();
+
+    bool loadModel();
+    void runInference();
+    void performUpdateSequence();
+    void downloadAndInstallModel();
+    void installDownloadedModel();
+    bool trainLocally(const QList<QList<BufferedSample>> &recent);
+    void installCandidate();
+    bool promoteCandidate(bool keepPrevious);
+    static QString liveModelPath();
+    void startShadow();
+    void finishShadow();
+
+    int triggerBuildJob();
+    bool waitForJob(int job_id, const QString &jobName);
+    bool attemptDownload(int retries);
+};
+
+#endif // MONITORCORE_H
@@ -0,0 +1,150 @@
+#include "opresolver.h"
+#include <QDebug>
+#include <QFile>
+#include <QTextStream>
+
+#include "tensorflow/lite/kernels/builtin_op_kernels.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/schema/schema_utils.h"
+#ifndef TFLITE_STATIC_OPS
+#include "tensorflow/lite/kernels/register.h"
+#endif
+
+using namespace tflite::ops::builtin;
+
+struct KernelEntry { tflite::BuiltinOperator op; TfLiteRegistration *(*reg)(); };
+
+// Kernels the trimmed resolver can register. Only referenced entries get linked in.
+static const KernelEntry KERNELS[] = {
+    // Edge Impulse int8 dense classifier
+    {tflite::BuiltinOperator_FULLY_CONNECTED, Register_FULLY_CONNECTED},
+    {tflite::BuiltinOperator_SOFTMAX, Register_SOFTMAX},
+    {tflite::BuiltinOperator_QUANTIZE, Register_QUANTIZE},
+    {tflite::BuiltinOperator_DEQUANTIZE, Register_DEQUANTIZE},
+    {tflite::BuiltinOperator_RESHAPE, Register_RESHAPE},
+#ifndef TFLITE_STATIC_OPS
+    // Other small-model ops, so a retrained impulse with a different head still loads trimmed
+    {tflite::BuiltinOperator_RELU, Register_RELU},
+    {tflite::BuiltinOperator_RELU6, Register_RELU6},
+    {tflite::BuiltinOperator_LOGISTIC, Register_LOGISTIC},
+    {tflite::BuiltinOperator_TANH, Register_TANH},
+    {tflite::BuiltinOperator_ADD, Register_ADD},
+    {tflite::BuiltinOperator_SUB, Register_SUB},
+    {tflite::BuiltinOperator_MUL, Register_MUL},
+    {tflite::BuiltinOperator_MEAN, Register_MEAN},
+    {tflite::BuiltinOperator_CONCATENATION, Register_CONCATENATION},
+    {tflite::BuiltinOperator_PAD, Register_PAD},
+    {tflite::BuiltinOperator_CONV_2D, Register_CONV_2D},
+    {tflite::BuiltinOperator_DEPTHWISE_CONV_2D, Register_DEPTHWISE_CONV_2D},
+    {tflite::BuiltinOperator_MAX_POOL_2D, Register_MAX_POOL_2D},
+    {tflite::BuiltinOperator_AVERAGE_POOL_2D, Register_AVERAGE_POOL_2D},
+    {tflite::BuiltinOperator_SQUEEZE, Register_SQUEEZE},
+    {tflite::BuiltinOperator_EXPAND_DIMS, Register_EXPAND_DIMS},
+    {tflite::BuiltinOperator_STRIDED_SLICE, Register_STRIDED_SLICE},
+    {tflite::BuiltinOperator_SHAPE, Register_SHAPE},
+    {tflite::BuiltinOperator_PACK, Register_PACK},
+    {tflite::BuiltinOperator_TRANSPOSE, Register_TRANSPOSE},
+#endif
+};
+
+TrimmedOpResolver::TrimmedOpResolver(const QList<ModelOp> &ops) {
+    for (const ModelOp &op : ops) {
+        const KernelEntry *entry = nullptr;
+        for (const KernelEntry &k : KERNELS) if (k.op == op.code) { entry = &k; break; }
+        if (!entry) { missing.append(tflite::EnumNameBuiltinOperator((tflite::BuiltinOperator)op.code)); continue; }
+        AddBuiltin(entry->op, entry->reg(), 1, op.version); registered++;
+    }
+}
+
+QList<ModelOp> TrimmedOpResolver::modelOps(const tflite::FlatBufferModel &model, bool *hasCustom) {
+    QList<ModelOp> ops; if (hasCustom) *hasCustom = false;
+    const auto *codes = model.GetModel()->operator_codes(); if (!codes) return ops;
+    for (const tflite::OperatorCode *code : *codes) {
+        tflite::BuiltinOperator op = tflite::GetBuiltinCode(code);
+        if (op == tflite::BuiltinOperator_CUSTOM) { if (hasCustom) *hasCustom = true; continue; }
+        bool found = false;
+        for (ModelOp &m : ops) if (m.code == op) { m.version = qMax(m.version, code->version()); found = true; }
+        if (!found) ops.append(ModelOp{op, qMax(1, code->version())});
+    }
+    return ops;
+}
+
+static bool saveOpList(const QString &modelPath, const QList<ModelOp> &ops, bool hasCustom) {
+    QString path = TrimmedOpResolver::opListPath(modelPath), tmp = path + ".tmp";
+    QFile file(tmp); if (!file.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) return false;
+    QTextStream out(&file);
+    for (const ModelOp &op : ops) out << op.code << ' ' << tflite::EnumNameBuiltinOperator((tflite::BuiltinOperator)op.code) << ' ' << op.version << '\n';
+    if (hasCustom) out << "custom\n";
+    out.flush(); file.close();
+    QFile::remove(path); return QFile::rename(tmp, path);
+}
+
+bool TrimmedOpResolver::writeOpList(const QString &modelPath) {
+    auto model = tflite::FlatBufferModel::BuildFromFile(modelPath.toLocal8Bit().constData()); if (!model) return false;
+    bool hasCustom; QList<ModelOp> ops = modelOps(*model, &hasCustom);
+    return saveOpList(modelPath, ops, hasCustom);
+}
+
+static bool readOpList(const QString &path, QList<ModelOp> *ops, bool *hasCustom) {
+    QFile file(path); if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return false;
+    QTextStream in(&file); *hasCustom = false;
+    while (!in.atEnd()) {
+        QStringList parts = in.readLine().split(' ');
+        if (parts.size() == 1 && parts[0] == "custom") *hasCustom = true;
+        else if (parts.size() == 3) ops->append(ModelOp{parts[0].toInt(), parts[2].toInt()});
+        else if (!parts[0].isEmpty()) return false;
+    }
+    return true;
+}
+
+// Cheap check that a cached list still covers the model: every builtin it uses is listed
+// with at least the version it needs (no list is built, only the opcode table is walked)
+static bool coversModel(const QList<ModelOp> &ops, bool hasCustom, const tflite::FlatBufferModel &model) {
+    const auto *codes = model.GetModel()->operator_codes(); if (!codes) return true;
+    for (const tflite::OperatorCode *code : *codes) {
+        tflite::BuiltinOperator op = tflite::GetBuiltinCode(code);
+        if (op == tflite::BuiltinOperator_CUSTOM) { if (!hasCustom) return false; continue; }
+        bool found = false;
+        for (const ModelOp &m : ops) if (m.code == op && m.version >= code->version()) { found = true; break; }
+        if (!found) return false;
+    }
+    return true;
+}
+
+QList<ModelOp> TrimmedOpResolver::opList(const QString &modelPath, const tflite::FlatBufferModel &model, bool *hasCustom) {
+    // The install-time list builds the resolver; the model in memory only has to be covered
+    // by it (a model restored with cp -p or swapped next to an old .ops would not be)
+    QList<ModelOp> ops;
+    if (readOpList(opListPath(modelPath), &ops, hasCustom) && coversModel(ops, *hasCustom, model)) return ops;
+    // Model installed by hand (or before op lists existed), or a stale list: derive it and cache for the next start
+    qDebug() << "Op list missing or stale, rewriting:" << opListPath(modelPath);
+    ops = modelOps(model, hasCustom);
+    saveOpList(modelPath, ops, *hasCustom);
+    return ops;
+}
+
+std::unique_ptr<tflite::OpResolver> TrimmedOpResolver::fullResolver() {
+#ifdef TFLITE_STATIC_OPS
+    return nullptr;
+#else
+    return std::unique_ptr<tflite::OpResolver>(new BuiltinOpResolver());
+#endif
+}
+
+std::unique_ptr<tflite::OpResolver> TrimmedOpResolver::create(const QString &modelPath, const tflite::FlatBufferModel &model, QString *description) {
+    bool hasCustom; QList<ModelOp> ops = opList(modelPath, model, &hasCustom);
+#ifndef TFLITE_STATIC_OPS
+    // MONITOR_RESOLVER=full: previous behaviour, to compare load time and RSS
+    if (qgetenv("MONITOR_RESOLVER") == "full") { *description = "full builtin resolver (MONITOR_RESOLVER=full)"; return fullResolver(); }
+#endif
+    std::unique_ptr<TrimmedOpResolver> trimmed(new TrimmedOpResolver(ops));
+    if (hasCustom) trimmed->missing.append("CUSTOM");
+    if (trimmed->isComplete()) { *description = QString("trimmed resolver, %1 ops").arg(trimmed->opCount()); return std::move(trimmed); }
+#ifdef TFLITE_STATIC_OPS
+    *description = "static op set, model needs " + trimmed->missingOps().join(", ");
+    return std::move(trimmed);
+#else
+    *description = "full builtin resolver, not in the trimmed set: " + trimmed->missingOps().join(", ");
+    return fullResolver();
+#endif
+}
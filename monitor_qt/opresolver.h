@@ -0,0 +1,58 @@
+#ifndef OPRESOLVER_H
+#define OPRESOLVER_H
+
+#include <QString>
+#include <QList>
+#include <QStringList>
+#include <memory>
+
+#include "tensorflow/lite/model.h"
+#include "tensorflow/lite/mutable_op_resolver.h"
+
+#define OP_LIST_SUFFIX ".ops"
+
+// One builtin operator used by a model: schema code and highest version needed
+struct ModelOp {
+    int code;
+    int version;
+};
+
+// Op resolver holding only the kernels a model uses, instead of the ~150 that
+// BuiltinOpResolver registers on every load. The op list is derived from the
+// model when it is installed and kept next to it as "<model>.ops"; loads build
+// the resolver from that file after checking it still covers the model (it is
+// derived again and rewritten if not):
+//   <builtin code> <name> <max version>
+// This saves registration work at load time. The binary only gets smaller, and
+// the unused kernels stay out of RSS, with CONFIG+=tflite_static_ops
+// (TFLITE_STATIC_OPS): only then are just the kernels of our impulse referenced,
+// with no BuiltinOpResolver fallback for models that need anything else. A
+// default build still links BuiltinOpResolver for that fallback.
+class TrimmedOpResolver : public tflite::MutableOpResolver
+{
+public:
+    explicit TrimmedOpResolver(const QList<ModelOp> &ops);
+
+    // False if an op (or a custom op) is not in the kernel table
+    bool isComplete() const { return missing.isEmpty(); }
+    QStringList missingOps() const { return missing; }
+    int opCount() const { return registered; }
+
+    static QList<ModelOp> modelOps(const tflite::FlatBufferModel &model, bool *hasCustom = nullptr);
+    static QString opListPath(const QString &modelPath) { return modelPath + OP_LIST_SUFFIX; }
+    // Install time: derive the op list of modelPath and write it next to the model
+    static bool writeOpList(const QString &modelPath);
+    // Op list of a loaded model from its .ops file; derived and rewritten if the file does not cover the model
+    static QList<ModelOp> opList(const QString &modelPath, const tflite::FlatBufferModel &model, bool *hasCustom);
+
+    // Trimmed resolver if it covers the model, else the full builtin one (unless TFLITE_STATIC_OPS)
+    static std::unique_ptr<tflite::OpResolver> create(const QString &modelPath, const tflite::FlatBufferModel &model, QString *description);
+    // BuiltinOpResolver, for a retry when a trimmed build fails; null with TFLITE_STATIC_OPS
+    static std::unique_ptr<tflite::OpResolver> fullResolver();
+
+private:
+    QStringList missing;
+    int registered = 0;
+};
+
+#endif // OPRESOLVER_H
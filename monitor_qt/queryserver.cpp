@@ -0,0 +1,73 @@
+#include "queryserver.h"
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QPointer>
+#include <QtConcurrent/QtConcurrent>
+
+static const char* FIELD_NAMES[HISTORY_FIELDS] = {"temp", "humid", "lux"};
+static const char* LABEL_NAMES[HISTORY_LABELS] = {"normal", "temp_inc, humid_dec", "temp_inc, humid_inc"};
+
+QueryServer::QueryServer(HistoryStore *store, QObject *parent) : QObject(parent), store(store)
+{
+    server = new QLocalServer(this);
+    // Owner only, like the core socket: zone history is not for every local account
+    server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(server, &QLocalServer::newConnection, this, &QueryServer::onNewConnection);
+}
+
+bool QueryServer::listen(const QString &name) {
+    QLocalServer::removeServer(name);
+    if (!server->listen(name)) { qDebug() << "Query: cannot listen on" << name << server->errorString(); return false; }
+    return true;
+}
+
+void QueryServer::onNewConnection() {
+    while (QLocalSocket *client = server->nextPendingConnection()) {
+        connect(client, &QLocalSocket::readyRead, this, &QueryServer::onClientReadyRead);
+        connect(client, &QLocalSocket::disconnected, client, &QLocalSocket::deleteLater);
+    }
+}
+
+void QueryServer::onClientReadyRead() {
+    QPointer<QLocalSocket> client = qobject_cast<QLocalSocket*>(sender());
+    while (client && client->canReadLine()) {
+        QJsonObject request = QJsonDocument::fromJson(client->readLine()).object();
+        QtConcurrent::run([=]() {
+            QByteArray reply = QJsonDocument(execute(request)).toJson(QJsonDocument::Compact) + "\n";
+            QMetaObject::invokeMethod(this, [=]() { if (client) client->write(reply); }, Qt::QueuedConnection);
+        });
+    }
+}
+
+QJsonObject QueryServer::execute(const QJsonObject &request) {
+    QString op = request["op"].toString(); int zone = request["zone"].toInt();
+    qint64 from = request["from"].toVariant().toLongLong(); qint64 to = request["to"].toVariant().toLongLong();
+    QJsonObject reply{{"op", op}, {"zone", zone}, {"from", from}, {"to", to}};
+    if (request.contains("id")) reply["id"] = request["id"];
+    if (zone < 0 || zone >= store->zoneCount()) { reply["error"] = "invalid zone"; return reply; }
+
+    if (op == "samples") {
+        int limit = request.contains("limit") ? qBound(1, request["limit"].toInt(), QUERY_MAX_SAMPLES) : QUERY_MAX_SAMPLES;
+        QJsonArray rows; bool truncated = false;
+        store->scan(zone, from, to, [&](const DaySegment &seg, int row) {
+            // One row past the limit means more exist: stop there so the rest of the range is never decoded
+            if (rows.size() >= limit) { truncated = true; return false; }
+            rows.append(QJsonArray{seg.ts[row], seg.value[0][row], seg.value[1][row], seg.value[2][row], LABEL_NAMES[seg.label[row]]});
+            return true;
+        });
+        reply["columns"] = QJsonArray{"ts", "temp", "humid", "lux", "label"};
+        reply["rows"] = rows; reply["truncated"] = truncated;
+    }
+    else if (op == "stats" || op == "labels") {
+        RangeStats st = store->stats(zone, from, to);
+        reply["count"] = st.count;
+        if (op == "stats" && st.count > 0) {
+            for (int i = 0; i < HISTORY_FIELDS; i++) reply[FIELD_NAMES[i]] = QJsonObject{{"min", st.min[i]}, {"max", st.max[i]}, {"avg", st.sum[i] / st.count}};
+        }
+        QJsonObject labels; for (int i = 0; i < HISTORY_LABELS; i++) labels[LABEL_NAMES[i]] = st.labelCounts[i];
+        reply["labels"] = labels;
+    }
+    else reply["error"] = "unknown op";
+    return reply;
+}
@@ -0,0 +1,35 @@
+#ifndef QUERYSERVER_H
+#define QUERYSERVER_H
+
+#include <QObject>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+
+#include "historystore.h"
+
+#define QUERY_MAX_SAMPLES 10000
+
+// Time-range queries over the CSV history on a local socket (see ipcprotocol.h).
+// Each request runs on the Qt thread pool, so logging and other queries
+// are never blocked by a slow scan.
+class QueryServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    QueryServer(HistoryStore *store, QObject *parent = nullptr);
+    bool listen(const QString &name);
+
+private slots:
+    void onNewConnection();
+    void onClientReadyRead();
+
+private:
+    HistoryStore *store;
+    QLocalServer *server;
+
+    QJsonObject execute(const QJsonObject &request);
+};
+
+#endif // QUERYSERVER_H
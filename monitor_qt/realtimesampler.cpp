@@ -0,0 +1,136 @@
+#include "realtimesampler.h"
+#include "virtualclock.h"
+#include <QDebug>
+#include <algorithm>
+
+#include <errno.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+// ---------------------------------------------------------------- ReadStats
+
+void ReadStats::record(double wake, double read, bool ok) {
+    QMutexLocker lock(&mutex);
+    if (wakeUs.isEmpty()) { wakeUs.resize(READ_STATS_RING); readUs.resize(READ_STATS_RING); }
+    wakeUs[ringPos % READ_STATS_RING] = wake; readUs[ringPos % READ_STATS_RING] = read; ringPos++;
+    reads++; if (!ok) failures++;
+    wakeMaxUs = qMax(wakeMaxUs, wake);
+}
+
+static float percentile(QVector<float> values, double p) {
+    if (values.isEmpty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values[qMin(values.size() - 1, (int)(p * values.size()))];
+}
+
+QString ReadStats::summary(const QString &name) const {
+    QMutexLocker lock(&mutex);
+    int n = qMin(ringPos, READ_STATS_RING); QVector<float> wake = wakeUs.mid(0, n), read = readUs.mid(0, n);
+    return QString("%1: %2 reads, %3% failed, wake-up p50 %4 / p99 %5 / max %6 us, read p50 %7 / p99 %8 us")
+        .arg(name).arg(reads).arg(reads > 0 ? 100.0 * failures / reads : 0.0, 0, 'f', 2)
+        .arg(percentile(wake, 0.5), 0, 'f', 0).arg(percentile(wake, 0.99), 0, 'f', 0).arg(wakeMaxUs, 0, 'f', 0)
+        .arg(percentile(read, 0.5), 0, 'f', 0).arg(percentile(read, 0.99), 0, 'f', 0);
+}
+
+QJsonObject ReadStats::toJson() const {
+    QMutexLocker lock(&mutex);
+    int n = qMin(ringPos, READ_STATS_RING); QVector<float> wake = wakeUs.mid(0, n), read = readUs.mid(0, n);
+    return QJsonObject{
+        {"reads", reads}, {"failures", failures}, {"failure_rate", reads > 0 ? (double)failures / reads : 0.0},
+        {"wake_p50_us", percentile(wake, 0.5)}, {"wake_p99_us", percentile(wake, 0.99)}, {"wake_max_us", wakeMaxUs},
+        {"read_p50_us", percentile(read, 0.5)}, {"read_p99_us", percentile(read, 0.99)}, {"read_max_us", percentile(read, 1.0)}
+    };
+}
+
+// ---------------------------------------------------------------- RealtimeSampler
+
+static qint64 monotonicNs() { struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts); return (qint64)ts.tv_sec * 1000000000LL + ts.tv_nsec; }
+
+RealtimeSampler::RealtimeSampler(const QList<ZonePipeline*> &zones, const AcquisitionConfig &acq, ReadStats *dhtStats, ReadStats *bhStats)
+    : zones(zones), dhtPeriodMs(acq.dhtPeriodMs), bhPeriodMs(acq.bhPeriodMs), rtCpu(acq.rtCpu), priority(acq.rtPriority), dhtStats(dhtStats), bhStats(bhStats)
+{
+    int cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (rtCpu < 0 || rtCpu >= cpus) rtCpu = cpus - 1;
+}
+
+RealtimeSampler::~RealtimeSampler() { stop(); }
+
+bool RealtimeSampler::lockMemory(QString *error) {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0) return true;
+    *error = QString("mlockall: %1").arg(strerror(errno)); return false;
+}
+
+bool RealtimeSampler::confineToOtherCores(int cpu, QString *error) {
+    int cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 2) { *error = "single core, nothing to isolate"; return false; }
+    cpu_set_t set; CPU_ZERO(&set);
+    for (int c = 0; c < cpus; c++) if (c != cpu) CPU_SET(c, &set);
+    int ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (ret != 0) { *error = QString("affinity: %1").arg(strerror(ret)); return false; }
+    return true;
+}
+
+bool RealtimeSampler::start(QString *info) {
+    pthread_attr_t attr; pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, RT_STACK_KB * 1024);
+    cpu_set_t set; CPU_ZERO(&set); CPU_SET(rtCpu, &set);
+    pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+    struct sched_param param; memset(&param, 0, sizeof(param)); param.sched_priority = priority;
+    pthread_attr_setschedparam(&attr, &param);
+
+    running = true;
+    int ret = pthread_create(&thread, &attr, &RealtimeSampler::run, this);
+    if (ret == EPERM) {
+        // No CAP_SYS_NICE / RLIMIT_RTPRIO: keep the dedicated core, normal policy
+        pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+        ret = pthread_create(&thread, &attr, &RealtimeSampler::run, this);
+        *info = QString("sensor thread on CPU %1, SCHED_FIFO not permitted (normal priority)").arg(rtCpu);
+    } else {
+        *info = QString("sensor thread on CPU %1, SCHED_FIFO %2").arg(rtCpu).arg(priority);
+    }
+    pthread_attr_destroy(&attr);
+    if (ret != 0) { running = false; *info = QString("cannot start sensor thread: %1").arg(strerror(ret)); return false; }
+    started = true;
+    return true;
+}
+
+void RealtimeSampler::stop() {
+    if (!started) return;
+    running = false; pthread_join(thread, nullptr); started = false;
+}
+
+void *RealtimeSampler::run(void *self) {
+    pthread_setname_np(pthread_self(), "monitor-rt");
+    static_cast<RealtimeSampler *>(self)->loop();
+    return nullptr;
+}
+
+void RealtimeSampler::loop() {
+    // Absolute deadlines: a late read does not shift the following ones
+    qint64 dhtPeriod = dhtPeriodMs * 1000000LL, bhPeriod = bhPeriodMs * 1000000LL;
+    qint64 nextDht = monotonicNs() + dhtPeriod, nextBh = monotonicNs() + bhPeriod;
+    while (running) {
+        bool dht = nextDht <= nextBh; qint64 deadline = dht ? nextDht : nextBh;
+        struct timespec ts = {(time_t)(deadline / 1000000000LL), (long)(deadline % 1000000000LL)};
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+        if (!running) break;
+
+        time_t now = VirtualClock::now();
+        for (ZonePipeline *zone : zones) {
+            // Per read: delay from the deadline to the start of this read (includes earlier zones' reads)
+            qint64 begin = monotonicNs();
+            bool ok = dht ? zone->sampleDHT11(now) : zone->sampleBH1750(now);
+            qint64 end = monotonicNs();
+            (dht ? dhtStats : bhStats)->record((begin - deadline) / 1000.0, (end - begin) / 1000.0, ok);
+        }
+        qint64 &next = dht ? nextDht : nextBh; qint64 period = dht ? dhtPeriod : bhPeriod;
+        next += period;
+        // Reads overran a whole period (slow sensor / many zones): skip the missed slots
+        qint64 now_ns = monotonicNs(); if (next < now_ns) next += ((now_ns - next) / period + 1) * period;
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef REALTIMESAMPLER_H
+#define REALTIMESAMPLER_H
+
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <QJsonObject>
+#include <atomic>
+#include <pthread.h>
+
+#include "zonepipeline.h"
+
+#define RT_STACK_KB       256     // locked by mlockall, keep the sampler and pool stacks small
+#define RT_POOL_STACK_KB  1024
+#define READ_STATS_RING   4096    // percentiles over the last N reads
+#define READ_STATS_REPORT_MIN 10
+
+// Scheduling latency of one sensor's reads: how late each read started after
+// its deadline (wake-up), how long the read took, and whether it gave a value.
+// Filled by the Qt timers in normal mode and by RealtimeSampler in real-time
+// mode, so the failure rate of both modes can be compared from the same report.
+class ReadStats
+{
+public:
+    void record(double wakeUs, double readUs, bool ok);
+    QString summary(const QString &name) const;
+    QJsonObject toJson() const;
+
+private:
+    mutable QMutex mutex;
+    qint64 reads = 0, failures = 0;
+    double wakeMaxUs = 0;
+    QVector<float> wakeUs, readUs;   // rings of READ_STATS_RING
+    int ringPos = 0;
+};
+
+// Reads every zone's sensors on a dedicated SCHED_FIFO thread pinned to one
+// core, at absolute CLOCK_MONOTONIC deadlines (clock_nanosleep), instead of on
+// Qt timers of the event-loop thread. The rest of the process is kept off that
+// core by confineToOtherCores() and its memory is locked so a read never waits
+// for a page fault. Readings go into the zones' decimators (under their mutex);
+// the event loop only reduces them.
+class RealtimeSampler
+{
+public:
+    RealtimeSampler(const QList<ZonePipeline*> &zones, const AcquisitionConfig &acq, ReadStats *dhtStats, ReadStats *bhStats);
+    ~RealtimeSampler();
+
+    // Starts the thread; falls back to normal priority (still pinned) without CAP_SYS_NICE
+    bool start(QString *info);
+    void stop();
+    int cpu() const { return rtCpu; }
+
+    // mlockall(MCL_CURRENT | MCL_FUTURE)
+    static bool lockMemory(QString *error);
+    // Affinity of the calling thread (and of every thread it creates later) = all cores but cpu
+    static bool confineToOtherCores(int cpu, QString *error);
+
+private:
+    QList<ZonePipeline*> zones;
+    int dhtPeriodMs, bhPeriodMs, rtCpu, priority;
+    ReadStats *dhtStats, *bhStats;
+    pthread_t thread;
+    bool started = false;
+    std::atomic<bool> running{false};
+
+    static void *run(void *self);
+    void loop();
+};
+
+#endif // REALTIMESAMPLER_H
@@ -0,0 +1,56 @@
+#include "replaysensorsource.h"
+#include "logcompactor.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSet>
+#include <QVector>
+#include <algorithm>
+
+ReplaySensorSource::ReplaySensorSource(const QString &path)
+{
+    QFileInfo info(path);
+    if (info.isDir()) {
+        QSet<QString> days;
+        for (const QString &name : QDir(path).entryList(LogCompactor::dayFileFilters(), QDir::Files, QDir::Name)) days.insert(name.left(10));
+        QStringList dayList = days.values(); std::sort(dayList.begin(), dayList.end());
+        for (const QString &day : dayList) loadFile(LogCompactor::dayFilePath(path, day));
+    } else {
+        loadFile(path);
+    }
+    if (rows.isEmpty()) { qDebug() << "Replay trace empty or unreadable:" << path; return; }
+    // Offsets from the first row; one median row interval past the last before starting over
+    qint64 first = rows.first().offsetMs;
+    for (Row &r : rows) r.offsetMs -= first;
+    // (median, not mean: a gap in the trace such as a daemon restart would stretch the pause)
+    QVector<qint64> steps; for (int i = 1; i < rows.size(); i++) steps.append(rows[i].offsetMs - rows[i - 1].offsetMs);
+    qint64 step = 1000;
+    if (!steps.isEmpty()) { std::nth_element(steps.begin(), steps.begin() + steps.size() / 2, steps.end()); step = qMax<qint64>(steps[steps.size() / 2], 1); }
+    spanMs = rows.last().offsetMs + step;
+}
+
+void ReplaySensorSource::loadFile(const QString &path) {
+    // readDayFile reads plain and gzip'ed logs alike
+    QByteArray data = LogCompactor::readDayFile(path);
+    for (const QByteArray &line : data.split('\n')) {
+        QList<QByteArray> parts = line.split(',');
+        if (parts.size() < 6) continue;
+        bool ok; qint64 ms = parts[0].toLongLong(&ok); if (!ok) continue; // header
+        Row r; r.offsetMs = ms; r.sample.temp = parts[3].toFloat(); r.sample.humid = parts[4].toFloat(); r.sample.lux = parts[5].toFloat();
+        // Rows must be in time order; a clock jump backwards in the log is skipped
+        if (!rows.isEmpty() && ms < rows.last().offsetMs) continue;
+        rows.append(r);
+    }
+}
+
+int ReplaySensorSource::read(SensorKind, time_t now, SensorSample *out, int max) {
+    if (rows.isEmpty()) return -1;
+    if (firstRead == 0) firstRead = now;
+    qint64 elapsedMs = (qint64)(now - firstRead) * 1000;
+    int count = 0;
+    while (count < max && lapStartMs + rows[next].offsetMs <= elapsedMs) {
+        out[count++] = rows[next].sample;
+        if (++next == rows.size()) { next = 0; lapStartMs += spanMs; }
+    }
+    return count;
+}
@@ -0,0 +1,35 @@
+#ifndef REPLAYSENSORSOURCE_H
+#define REPLAYSENSORSOURCE_H
+
+#include <QString>
+#include <QVector>
+
+#include "sensorsource.h"
+
+// Recorded trace played back as a sensor: a zone log as written by ZonePipeline
+// (yyyy-MM-dd.csv or .csv.gz, "timestamp,min_sin,min_cos,temp,humid,lux,label")
+// or a directory of them. The first read is aligned with the first row; each
+// read then returns every row whose time has come since the previous read, on
+// the monitoring clock (so --speed replays faster). Starts over at the end.
+class ReplaySensorSource : public SensorSource
+{
+public:
+    explicit ReplaySensorSource(const QString &path);
+
+    bool isValid() const { return !rows.isEmpty(); }
+    int read(SensorKind kind, time_t now, SensorSample *out, int max) override;
+    QString backend() const override { return "replay"; }
+
+private:
+    struct Row { qint64 offsetMs; SensorSample sample; };
+
+    QVector<Row> rows;
+    qint64 spanMs = 0;
+    time_t firstRead = 0;
+    qint64 lapStartMs = 0;
+    int next = 0;
+
+    void loadFile(const QString &path);
+};
+
+#endif // REPLAYSENSORSOURCE_H
@@ -0,0 +1,90 @@
+#include "rollupstore.h"
+#include "historystore.h"
+#include "virtualclock.h"
+#include <QDebug>
+#include <QDir>
+
+#include <time.h>
+#include <float.h>
+
+ZoneRollup::ZoneRollup(const QString &dataDir)
+{
+    QDir().mkpath(dataDir);
+    for (int t = 0; t < ROLLUP_TIERS; t++) {
+        ring[t].resize(ROLLUP_CAPACITY[t]); currentIdx[t] = -1;
+        file[t].setFileName(QString("%1/rollup_%2.bin").arg(dataDir).arg(ROLLUP_TIER_NAMES[t]));
+        load(t);
+    }
+}
+
+// Buckets follow local time (TZ), so a day bucket starts at local midnight
+qint64 ZoneRollup::bucketIndex(qint64 ts, int tier) {
+    time_t t = (time_t)ts; struct tm tm_info; localtime_r(&t, &tm_info);
+    return (ts + tm_info.tm_gmtoff) / ROLLUP_PERIOD_S[tier];
+}
+
+qint64 ZoneRollup::bucketStart(qint64 idx, qint64 ts, int tier) {
+    time_t t = (time_t)ts; struct tm tm_info; localtime_r(&t, &tm_info);
+    return idx * ROLLUP_PERIOD_S[tier] - tm_info.tm_gmtoff;
+}
+
+void ZoneRollup::load(int tier) {
+    qint64 expected = (qint64)ROLLUP_CAPACITY[tier] * sizeof(RollupBucket);
+    if (!file[tier].open(QIODevice::ReadWrite)) { qDebug() << "Rollup: cannot open" << file[tier].fileName(); return; }
+    if (file[tier].size() == expected) {
+        file[tier].read((char*)ring[tier].data(), expected);
+    } else {
+        // New file or different layout: start over with empty slots
+        file[tier].resize(0); file[tier].resize(expected);
+    }
+}
+
+void ZoneRollup::writeSlot(int tier, const RollupBucket &b) {
+    if (!file[tier].isOpen()) return;
+    qint64 slot = bucketIndex(b.start, tier) % ROLLUP_CAPACITY[tier];
+    if (file[tier].seek(slot * sizeof(RollupBucket))) { file[tier].write((const char*)&b, sizeof(RollupBucket)); file[tier].flush(); }
+}
+
+int ZoneRollup::addSample(qint64 ts, float temp, float humid, float lux) {
+    float v[ROLLUP_FIELDS] = {temp, humid, lux}; int mask = 0;
+    for (int t = 0; t < ROLLUP_TIERS; t++) {
+        qint64 idx = bucketIndex(ts, t);
+        if (idx != currentIdx[t]) {
+            if (current[t].count > 0) {
+                ring[t][currentIdx[t] % ROLLUP_CAPACITY[t]] = current[t];
+                closed[t] = current[t]; writeSlot(t, current[t]); mask |= 1 << t;
+            }
+            // Resume a bucket persisted before a restart, otherwise start an empty one
+            RollupBucket &slot = ring[t][idx % ROLLUP_CAPACITY[t]];
+            if (slot.count > 0 && bucketIndex(slot.start, t) == idx) { current[t] = slot; slot = RollupBucket(); }
+            else { current[t] = RollupBucket(); current[t].start = bucketStart(idx, ts, t); for (int i = 0; i < ROLLUP_FIELDS; i++) { current[t].min[i] = FLT_MAX; current[t].max[i] = -FLT_MAX; } }
+            currentIdx[t] = idx;
+        }
+        RollupBucket &b = current[t]; b.count++;
+        for (int i = 0; i < ROLLUP_FIELDS; i++) { if (v[i] < b.min[i]) b.min[i] = v[i]; if (v[i] > b.max[i]) b.max[i] = v[i]; b.sum[i] += v[i]; }
+    }
+    // Current hour/day buckets are saved once a minute, a restart loses at most one minute
+    if (mask & (1 << ROLLUP_MINUTE)) for (int t = ROLLUP_HOUR; t < ROLLUP_TIERS; t++) writeSlot(t, current[t]);
+    return mask;
+}
+
+void ZoneRollup::addLabel(qint64 ts, const QString &label) {
+    int l = HistoryStore::labelIndex(label);
+    for (int t = 0; t < ROLLUP_TIERS; t++) {
+        qint64 idx = bucketIndex(ts, t);
+        if (idx == currentIdx[t]) { current[t].labelCounts[l]++; continue; }
+        RollupBucket &b = ring[t][idx % ROLLUP_CAPACITY[t]];
+        if (b.count > 0 && bucketIndex(b.start, t) == idx) { b.labelCounts[l]++; writeSlot(t, b); }
+    }
+}
+
+QVector<RollupBucket> ZoneRollup::latest(int tier, int count) const {
+    QVector<RollupBucket> out;
+    qint64 cur = currentIdx[tier] >= 0 ? currentIdx[tier] : bucketIndex(VirtualClock::now(), tier);
+    count = qMin(count, ROLLUP_CAPACITY[tier]);
+    for (qint64 idx = qMax((qint64)0, cur - count); idx < cur; idx++) {
+        const RollupBucket &b = ring[tier][idx % ROLLUP_CAPACITY[tier]];
+        if (b.count > 0 && bucketIndex(b.start, tier) == idx) out.append(b);
+    }
+    return out;
+}
@@ -0,0 +1,61 @@
+#ifndef ROLLUPSTORE_H
+#define ROLLUPSTORE_H
+
+#include <QString>
+#include <QVector>
+#include <QFile>
+
+#define ROLLUP_TIERS 3
+#define ROLLUP_FIELDS 3      // temp, humid, lux
+#define ROLLUP_LABELS 3
+
+enum RollupTier { ROLLUP_MINUTE = 0, ROLLUP_HOUR = 1, ROLLUP_DAY = 2 };
+
+static const char* const ROLLUP_TIER_NAMES[ROLLUP_TIERS] = {"minute", "hour", "day"};
+static const int ROLLUP_PERIOD_S[ROLLUP_TIERS] = {60, 3600, 86400};
+// Buckets kept per tier: 1 day of minutes, 35 days of hours, 400 days
+static const int ROLLUP_CAPACITY[ROLLUP_TIERS] = {1440, 840, 400};
+
+// Summary of one minute/hour/day. Stored as-is (native layout, 72 bytes) in the tier file.
+struct RollupBucket {
+    qint64 start = -1;                        // unix seconds, local bucket boundary; -1 = empty slot
+    qint32 count = 0;
+    qint32 labelCounts[ROLLUP_LABELS] = {0, 0, 0};
+    float min[ROLLUP_FIELDS];
+    float max[ROLLUP_FIELDS];
+    double sum[ROLLUP_FIELDS] = {0, 0, 0};
+};
+
+// Minute, hour and day rollups of one zone, updated in O(1) per sample.
+// Each tier is a ring of fixed-size slots (slot = bucket number % capacity),
+// mirrored 1:1 in <dataDir>/rollup_<tier>.bin, so a bucket is persisted or
+// patched with a single write at a known offset and the files never grow.
+// Labels are only final when ZonePipeline flushes a sample to CSV (~30 min
+// later), so they are added separately into the bucket the sample belongs to.
+class ZoneRollup
+{
+public:
+    explicit ZoneRollup(const QString &dataDir);
+
+    // Returns a bitmask (1 << tier) of the buckets closed by this sample, see lastClosed()
+    int addSample(qint64 ts, float temp, float humid, float lux);
+    void addLabel(qint64 ts, const QString &label);
+
+    const RollupBucket &lastClosed(int tier) const { return closed[tier]; }
+    // Up to `count` most recent closed buckets of a tier, oldest first
+    QVector<RollupBucket> latest(int tier, int count) const;
+
+private:
+    QVector<RollupBucket> ring[ROLLUP_TIERS];
+    RollupBucket current[ROLLUP_TIERS];
+    RollupBucket closed[ROLLUP_TIERS];
+    qint64 currentIdx[ROLLUP_TIERS];
+    QFile file[ROLLUP_TIERS];
+
+    static qint64 bucketIndex(qint64 ts, int tier);
+    static qint64 bucketStart(qint64 idx, qint64 ts, int tier);
+    void load(int tier);
+    void writeSlot(int tier, const RollupBucket &b);
+};
+
+#endif // ROLLUPSTORE_H
@@ -0,0 +1,207 @@
+#include "sensorsource.h"
+#include "iiosensorsource.h"
+#include "replaysensorsource.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+#include <QRegExp>
+#include <QMutexLocker>
+
+// C System Headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <math.h>
+#include <string.h>
+
+SensorSource *SensorSource::create(const QString &dev, SensorKind kind, int zoneIndex) {
+    if (dev == SIM_DEVICE) return new SimSensorSource(QString(), zoneIndex);
+    if (dev.startsWith(SIM_PREFIX)) return new SimSensorSource(dev.mid(strlen(SIM_PREFIX)), zoneIndex);
+    if (dev == AUTO_DEVICE) return new AutoSensorSource(kind, zoneIndex);
+    if (dev.startsWith(REPLAY_PREFIX)) return new ReplaySensorSource(dev.mid(strlen(REPLAY_PREFIX)));
+    if (dev.startsWith(IIO_PREFIX)) {
+        // Buffered if the driver and a trigger allow it, else direct sysfs reads
+        IioSensorSource *iio = new IioSensorSource(dev.mid(strlen(IIO_PREFIX)), kind, true);
+        if (iio->isValid()) return iio;
+        qDebug() << dev << "not buffered:" << iio->errorString(); delete iio;
+        iio = new IioSensorSource(dev.mid(strlen(IIO_PREFIX)), kind, false);
+        if (!iio->isValid()) qDebug() << dev << iio->errorString();
+        return iio;
+    }
+    return new DeviceSensorSource(dev);
+}
+
+int SensorSource::readTimed(SensorKind kind, time_t now, SensorSample *out, int max) {
+    QElapsedTimer timer; timer.start();
+    int n = read(kind, now, out, max);
+    readCost.totalNs += timer.nsecsElapsed(); readCost.calls++;
+    if (n < 0) readCost.failures++; else readCost.samples += n;
+    return n;
+}
+
+QString SensorSource::costSummary() const {
+    return QString("%1 %2 us/read, %3 us/sample (%4 reads, %5 samples, %6 failed)").arg(backend())
+        .arg(readCost.usPerRead(), 0, 'f', 0).arg(readCost.usPerSample(), 0, 'f', 0)
+        .arg((qint64)readCost.calls).arg((qint64)readCost.samples).arg((qint64)readCost.failures);
+}
+
+int SingleShotSource::read(SensorKind kind, time_t now, SensorSample *out, int max) {
+    if (max < 1) return 0;
+    SensorSample sample; int ret = kind == SENSOR_DHT11 ? readDHT11(now, &sample.temp, &sample.humid) : readBH1750(now, &sample.lux);
+    if (ret != 0) return -1;
+    out[0] = sample; return 1;
+}
+
+// ============================================================================
+//  AUTO SELECTION
+// ============================================================================
+
+AutoSensorSource::AutoSensorSource(SensorKind kind, int zoneIndex)
+{
+    // Same numbering as the drivers: n-th DHT11 for zone n. bh1750_driver has a single /dev/bh1750,
+    // shared by every zone; over IIO the n-th BH1750 if the board has one per zone, else that one too
+    name = kind == SENSOR_DHT11 ? "dht11" : "bh1750";
+    int ordinal = kind == SENSOR_BH1750 && IioSensorSource::findDevice(name, zoneIndex).isEmpty() ? 0 : zoneIndex;
+    QString spec = QString("%1#%2").arg(name).arg(ordinal);
+    for (bool buffered : {true, false}) {
+        IioSensorSource *iio = new IioSensorSource(spec, kind, buffered);
+        if (iio->isValid()) candidates.append(iio); else delete iio;
+    }
+    QString chardev = kind == SENSOR_DHT11 ? QString("/dev/dht11-%1").arg(zoneIndex) : QString("/dev/bh1750");
+    if (QFileInfo::exists(chardev)) candidates.append(new DeviceSensorSource(chardev));
+    if (candidates.isEmpty()) qDebug() << "Zone" << zoneIndex << name << ": no IIO device or" << chardev << "found";
+    else if (candidates.size() == 1) chosen = candidates.first();
+}
+
+AutoSensorSource::~AutoSensorSource() { qDeleteAll(candidates); }
+
+QString AutoSensorSource::backend() const {
+    QMutexLocker lock(&mutex);
+    SensorSource *c = chosen;
+    return c ? "auto:" + c->backend() : QString("auto (probing %1)").arg(candidates.size());
+}
+
+int AutoSensorSource::read(SensorKind kind, time_t now, SensorSample *out, int max) {
+    SensorSource *c = chosen;
+    if (c) return c->readTimed(kind, now, out, max);
+    // Round robin over the candidates at the normal read rate, each keeping its own cost.
+    // Only this (reading) thread deletes candidates, so the probe needs no lock while it reads
+    SensorSource *probe;
+    { QMutexLocker lock(&mutex); if (candidates.isEmpty()) return -1; probe = candidates[probeReads % candidates.size()]; }
+    int n = probe->readTimed(kind, now, out, max);
+    QMutexLocker lock(&mutex);
+    if (++probeReads >= AUTO_PROBE_READS * candidates.size()) choose();
+    return n;
+}
+
+// Called with the mutex held
+void AutoSensorSource::choose() {
+    // Cheapest per valid sample; a backend that never produced one only wins if nothing did
+    SensorSource *best = nullptr; QStringList table;
+    for (SensorSource *c : candidates) {
+        table << c->costSummary();
+        if (c->cost().samples == 0) continue;
+        if (!best || c->cost().usPerSample() < best->cost().usPerSample()) best = c;
+    }
+    if (!best) best = candidates.first();
+    qInfo().noquote() << QString("Sensor %1: %2 -> %3").arg(name, table.join("; "), best->backend());
+    // Release the others (an enabled IIO buffer keeps filling otherwise)
+    for (SensorSource *c : candidates) if (c != best) delete c;
+    candidates = QList<SensorSource *>() << best;
+    chosen = best;
+}
+
+int DeviceSensorSource::readDHT11(time_t, float *temp, float *hum) { int fd = open(dev.constData(), O_RDONLY); if (fd < 0) return -1; char tmp[64] = {0}; int ret = -1; if (read(fd, tmp, 63) > 0) { if (sscanf(tmp, "Temp: %f C, Hum: %f %%", temp, hum) == 2) ret = 0; else if(sscanf(tmp, "%f %f", temp, hum) == 2) ret = 0; } ::close(fd); return ret; }
+int DeviceSensorSource::readBH1750(time_t, float *lux) { int fd = open(dev.constData(), O_RDONLY); if (fd < 0) return -1; char tmp[32] = {0}; int ret = -1; if (read(fd, tmp, 31) > 0) { *lux = atof(tmp); ret = 0; } ::close(fd); return ret; }
+
+// ============================================================================
+//  SIMULATED SENSOR
+// ============================================================================
+
+SimSensorSource::SimSensorSource(const QString &profilePath, int zoneIndex) : zoneIndex(zoneIndex)
+{
+    rng = 1 + zoneIndex;
+    if (!profilePath.isEmpty() && !loadProfile(profilePath)) qDebug() << "Sim profile not readable, using the default curve:" << profilePath;
+}
+
+SimSensorSource::Fault SimSensorSource::faultFromName(const QString &name) {
+    if (name == "timeout") return FAULT_TIMEOUT; if (name == "zero") return FAULT_ZERO;
+    if (name == "stuck") return FAULT_STUCK; if (name == "spike") return FAULT_SPIKE;
+    return FAULT_NONE;
+}
+
+bool SimSensorSource::loadProfile(const QString &path) {
+    QFile file(path); if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return false;
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        QStringList parts = in.readLine().section('#', 0, 0).trimmed().split(QRegExp("\\s+"), QString::SkipEmptyParts);
+        if (parts.isEmpty()) continue;
+        if (parts[0] == "event" && parts.size() >= 6) {
+            Segment s; s.startMin = parts[1].toFloat(); s.durationMin = qMax(parts[2].toFloat(), 0.1f); s.fault = FAULT_NONE;
+            for (int i = 0; i < 3; i++) s.delta[i] = parts[3 + i].toFloat();
+            segments.append(s);
+        } else if (parts[0] == "fault" && parts.size() >= 4 && faultFromName(parts[3]) != FAULT_NONE) {
+            Segment s = {parts[1].toFloat(), parts[2].toFloat(), {0, 0, 0}, faultFromName(parts[3])};
+            segments.append(s);
+        } else if (parts[0] == "fault_rate" && parts.size() >= 3 && faultFromName(parts[1]) != FAULT_NONE) {
+            faultRate[faultFromName(parts[1])] = parts[2].toFloat();
+        } else {
+            for (const QString &kv : parts) {
+                QString key = kv.section('=', 0, 0); float value = kv.section('=', 1).toFloat();
+                if (key == "temp") base[0] = value; else if (key == "humid") base[1] = value; else if (key == "lux") base[2] = value;
+                else if (key == "temp_amp") amplitude[0] = value; else if (key == "humid_amp") amplitude[1] = value; else if (key == "lux_amp") amplitude[2] = value;
+                else if (key == "noise") noise = value; else if (key == "repeat_min") repeatMin = value;
+                else if (key == "seed") rng = (unsigned int)value * 7919u + zoneIndex + 1;
+                else qDebug() << "Sim profile: unknown setting" << kv;
+            }
+        }
+    }
+    return true;
+}
+
+// Own generator so runs are repeatable per seed and zone
+float SimSensorSource::random01() { return rand_r(&rng) / ((float)RAND_MAX + 1.0f); }
+
+// Day/night profile shifted per zone, with a little noise so event detection has something to do
+void SimSensorSource::generate(time_t now, float *values) {
+    struct tm tm_info; localtime_r(&now, &tm_info); float min_of_day = tm_info.tm_hour * 60.0 + tm_info.tm_min;
+    float day = sin(2 * M_PI * (min_of_day - 360.0) / 1440.0);
+    float n = random01() - 0.5f;
+    values[0] = base[0] + amplitude[0] * day + zoneIndex * 0.5f + n * 0.2f * noise;
+    values[1] = base[1] + amplitude[1] * day + n * noise;
+    values[2] = day > 0 ? base[2] * amplitude[2] * day + n * 10.0f * noise : 0.0f;
+
+    // Scripted events: linear ramp to +delta over duration, then back over the same time
+    float t = (now - firstRead) / 60.0f; if (repeatMin > 0) t = fmodf(t, repeatMin);
+    for (const Segment &s : segments) {
+        if (s.fault != FAULT_NONE || t < s.startMin || t >= s.startMin + 2 * s.durationMin) continue;
+        float x = (t - s.startMin) / s.durationMin; float shape = x < 1 ? x : 2 - x;
+        for (int i = 0; i < 3; i++) values[i] += s.delta[i] * shape;
+    }
+    if (values[2] < 0) values[2] = 0;
+}
+
+SimSensorSource::Fault SimSensorSource::activeFault(time_t now) {
+    float t = (now - firstRead) / 60.0f; if (repeatMin > 0) t = fmodf(t, repeatMin);
+    for (const Segment &s : segments) if (s.fault != FAULT_NONE && t >= s.startMin && t < s.startMin + s.durationMin) return s.fault;
+    for (int f = FAULT_TIMEOUT; f < FAULT_KINDS; f++) if (faultRate[f] > 0 && random01() < faultRate[f]) return (Fault)f;
+    return FAULT_NONE;
+}
+
+int SimSensorSource::read(time_t now, float *values) {
+    if (firstRead == 0) { firstRead = now; generate(now, last); }
+    switch (activeFault(now)) {
+    case FAULT_TIMEOUT: return -1;                                           // driver -ETIMEDOUT / checksum error
+    case FAULT_ZERO: values[0] = values[1] = values[2] = 0; return 0;        // all-zero frame, rejected by ZonePipeline
+    case FAULT_STUCK: for (int i = 0; i < 3; i++) values[i] = last[i]; return 0;
+    case FAULT_SPIKE: generate(now, values); values[0] += 40.0f; values[1] = 100.0f; values[2] = 65535.0f; return 0;   // outlier for the decimator
+    default: generate(now, values); for (int i = 0; i < 3; i++) last[i] = values[i]; return 0;
+    }
+}
+
+int SimSensorSource::readDHT11(time_t now, float *temp, float *hum) { float v[3]; int ret = read(now, v); if (ret == 0) { *temp = v[0]; *hum = v[1]; } return ret; }
+int SimSensorSource::readBH1750(time_t now, float *lux) { float v[3]; int ret = read(now, v); if (ret == 0) *lux = v[2]; return ret; }
@@ -0,0 +1,149 @@
+#ifndef SENSORSOURCE_H
+#define SENSORSOURCE_H
+
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QMutex>
+#include <atomic>
+#include <memory>
+#include <time.h>
+
+#define SIM_DEVICE      "sim"
+#define SIM_PREFIX      "sim:"     // "sim:/etc/monitor_sim.conf" = scripted profile
+#define AUTO_DEVICE     "auto"     // fastest of IIO buffered / IIO / chardev found on this board
+#define IIO_PREFIX      "iio:"     // "iio:<name>[#n][@trigger]", IioSensorSource
+#define REPLAY_PREFIX   "replay:"  // "replay:<zone log file or dir>", ReplaySensorSource
+#define SENSOR_BATCH_MAX 32
+#define AUTO_PROBE_READS 3         // reads per candidate before "auto" settles on one
+
+enum SensorKind { SENSOR_DHT11 = 0, SENSOR_BH1750 };
+
+// One reading. DHT11 sources fill temp/humid, BH1750 sources lux.
+struct SensorSample {
+    float temp = 0;
+    float humid = 0;
+    float lux = 0;
+};
+
+// Time spent in read() per backend, so boards can be compared (and "auto" can choose)
+struct SensorCost {
+    std::atomic<qint64> calls{0}, samples{0}, failures{0}, totalNs{0};
+    double usPerRead() const { return calls > 0 ? totalNs / 1000.0 / calls : 0; }
+    double usPerSample() const { return samples > 0 ? totalNs / 1000.0 / samples : 0; }
+};
+
+// Where a zone's readings come from (sensor HAL). ZonePipeline asks its DHT11
+// source for temperature/humidity and its BH1750 source for lux through the
+// batched read(): every reading available now, at most max. Blocking backends
+// (chardev, IIO sysfs) return one; buffered ones whatever queued since the last
+// call, 0 if nothing did yet. -1 = read failed (driver error, timeout).
+class SensorSource
+{
+public:
+    virtual ~SensorSource() {}
+    virtual int read(SensorKind kind, time_t now, SensorSample *out, int max) = 0;
+    virtual QString backend() const = 0;
+
+    // read() with its cost accounted
+    int readTimed(SensorKind kind, time_t now, SensorSample *out, int max);
+    const SensorCost &cost() const { return readCost; }
+    QString costSummary() const;
+
+    // Device string from the zones config: a /dev node, "auto", "iio:<name>",
+    // "replay:<path>", "sim" or "sim:<profile>"
+    static SensorSource *create(const QString &dev, SensorKind kind, int zoneIndex);
+
+private:
+    SensorCost readCost;
+};
+
+// Sources that produce one reading per call, per sensor type: 0 = valid reading
+// (same contract as the character device drivers)
+class SingleShotSource : public SensorSource
+{
+public:
+    int read(SensorKind kind, time_t now, SensorSample *out, int max) override;
+    virtual int readDHT11(time_t now, float *temp, float *hum) = 0;
+    virtual int readBH1750(time_t now, float *lux) = 0;
+};
+
+// /dev/dht11-N, /dev/bh1750 text interface of the kernel drivers
+class DeviceSensorSource : public SingleShotSource
+{
+public:
+    explicit DeviceSensorSource(const QString &dev) : dev(dev.toLocal8Bit()) {}
+    int readDHT11(time_t now, float *temp, float *hum) override;
+    int readBH1750(time_t now, float *lux) override;
+    QString backend() const override { return "chardev"; }
+
+private:
+    QByteArray dev;
+};
+
+// Synthetic sensor for bench and soak runs. Base day/night curve (shifted per
+// zone) plus noise, scripted events that ramp the values up and back down, and
+// injected faults, all in virtual minutes since the first read. Profile file:
+//   temp=28 temp_amp=3 humid=65 humid_amp=-8 lux=500 noise=1 seed=1 repeat_min=1440
+//   event <start_min> <duration_min> <d_temp> <d_humid> <d_lux>
+//   fault <start_min> <duration_min> timeout|zero|stuck|spike
+//   fault_rate timeout|zero|stuck|spike <probability per read>
+// Settings may share a line; '#' starts a comment.
+class SimSensorSource : public SingleShotSource
+{
+public:
+    SimSensorSource(const QString &profilePath, int zoneIndex);
+    int readDHT11(time_t now, float *temp, float *hum) override;
+    int readBH1750(time_t now, float *lux) override;
+    QString backend() const override { return "sim"; }
+
+private:
+    enum Fault { FAULT_NONE = 0, FAULT_TIMEOUT, FAULT_ZERO, FAULT_STUCK, FAULT_SPIKE, FAULT_KINDS };
+    struct Segment { float startMin; float durationMin; float delta[3]; Fault fault; };
+
+    float base[3] = {28.0f, 65.0f, 500.0f};
+    float amplitude[3] = {3.0f, -8.0f, 1.0f};   // lux: fraction of the daylight curve
+    float noise = 1.0f;
+    float repeatMin = 0;
+    float faultRate[FAULT_KINDS] = {0};
+    QList<Segment> segments;
+
+    int zoneIndex;
+    unsigned int rng;
+    time_t firstRead = 0;
+    float last[3] = {0, 0, 0};
+
+    bool loadProfile(const QString &path);
+    static Fault faultFromName(const QString &name);
+    float random01();
+    void generate(time_t now, float *values);
+    Fault activeFault(time_t now);
+    int read(time_t now, float *values);
+};
+
+// "auto": every backend this board offers for the sensor (the DHT11 of the
+// zone's number; the BH1750 of that number or the one shared by all zones), tried in turn for
+// AUTO_PROBE_READS reads each (normal read spacing, so the DHT11 is never
+// polled faster than configured), then the one with the lowest cost per
+// valid sample is kept. The comparison is logged.
+class AutoSensorSource : public SensorSource
+{
+public:
+    AutoSensorSource(SensorKind kind, int zoneIndex);
+    ~AutoSensorSource();
+    int read(SensorKind kind, time_t now, SensorSample *out, int max) override;
+    QString backend() const override;
+
+private:
+    QString name;
+    // read() runs on the sampling thread, backend() on the stats report: the probing
+    // state is under the mutex, chosen is set once (under it) and then read lock-free
+    mutable QMutex mutex;
+    QList<SensorSource *> candidates;
+    std::atomic<SensorSource *> chosen{nullptr};
+    int probeReads = 0;
+
+    void choose();
+};
+
+#endif // SENSORSOURCE_H
@@ -0,0 +1,90 @@
+#include "shadowevaluator.h"
+#include "monitorcore.h"
+#include "virtualclock.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <algorithm>
+
+#include "opresolver.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+ShadowEvaluator::ShadowEvaluator(const QString &modelPath, int batch, const ShadowConfig &cfg) : path(modelPath), cfg(cfg)
+{
+    started = VirtualClock::now();
+    long before = residentKb();
+    model = tflite::FlatBufferModel::BuildFromFile(modelPath.toLocal8Bit().constData());
+    if (!model) { error = "cannot read model file"; return; }
+    QString resolverInfo; std::unique_ptr<tflite::OpResolver> resolver = TrimmedOpResolver::create(modelPath, *model, &resolverInfo);
+    tflite::InterpreterBuilder builder(*model, *resolver); builder(&interpreter);
+    if (!interpreter) { error = "cannot build interpreter (" + resolverInfo + ")"; return; }
+    // Same batch layout as the live interpreter, so both see identical input tensors
+    if (batch > 1 && interpreter->ResizeInputTensor(interpreter->inputs()[0], {batch, MODEL_INPUT_COUNT}) != kTfLiteOk) { error = "cannot resize batch"; return; }
+    if (interpreter->AllocateTensors() != kTfLiteOk) { error = "tensor allocation failed"; return; }
+    TfLiteTensor *output = interpreter->tensor(interpreter->outputs()[0]);
+    if (output->dims->data[output->dims->size - 1] != NUM_LABELS) { error = "output is not " + QString::number(NUM_LABELS) + " labels"; return; }
+    memoryKb = residentKb() - before;
+}
+
+long ShadowEvaluator::residentKb() {
+    long pages = 0; FILE *f = fopen("/proc/self/statm", "r");
+    if (f) { if (fscanf(f, "%*ld %ld", &pages) != 1) pages = 0; fclose(f); }
+    return pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+double ShadowEvaluator::percentile(QVector<double> values, double p) {
+    if (values.isEmpty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values[qMin(values.size() - 1, (int)(p * values.size()))];
+}
+
+void ShadowEvaluator::evaluate(const float *features, int rows, const int *liveLabels, double liveMs) {
+    if (!isValid()) return;
+    TfLiteTensor *input = interpreter->tensor(interpreter->inputs()[0]); int total_inputs = rows * MODEL_INPUT_COUNT;
+    if (input->type == kTfLiteInt8) quantizeInt8(features, total_inputs, input->params.scale, input->params.zero_point, interpreter->typed_input_tensor<int8_t>(0));
+    else { float *input_data = interpreter->typed_input_tensor<float>(0); for (int i = 0; i < total_inputs; i++) input_data[i] = features[i]; }
+
+    QElapsedTimer timer; timer.start();
+    if (interpreter->Invoke() != kTfLiteOk) { error = "Invoke() failed"; return; }
+    candidateLatency.append(timer.nsecsElapsed() / 1e6); liveLatency.append(liveMs);
+
+    TfLiteTensor *output = interpreter->tensor(interpreter->outputs()[0]);
+    for (int b = 0; b < rows; b++) {
+        if (liveLabels[b] < 0) continue;
+        float probs[NUM_LABELS];
+        if (output->type == kTfLiteInt8) { int8_t *out_data = interpreter->typed_output_tensor<int8_t>(0) + b * NUM_LABELS; for (int i = 0; i < NUM_LABELS; i++) probs[i] = (out_data[i] - output->params.zero_point) * output->params.scale; }
+        else { float *out_data = interpreter->typed_output_tensor<float>(0) + b * NUM_LABELS; for (int i = 0; i < NUM_LABELS; i++) probs[i] = out_data[i]; }
+        int max_idx = 0; for (int i = 1; i < NUM_LABELS; i++) if (probs[i] > probs[max_idx]) max_idx = i;
+        windows++; if (max_idx == liveLabels[b]) agreed++;
+    }
+}
+
+bool ShadowEvaluator::isFinished(time_t now) const {
+    if (!isValid()) return true;
+    return now - started >= cfg.minutes * 60 && windows >= cfg.minWindows;
+}
+
+bool ShadowEvaluator::passed(QString *reason) const {
+    if (!isValid()) { *reason = error; return false; }
+    double liveP95 = percentile(liveLatency, 0.95), candP95 = percentile(candidateLatency, 0.95);
+    double agreement = windows > 0 ? (double)agreed / windows : 0;
+    if (cfg.maxLatencyRatio > 0 && candP95 > liveP95 * cfg.maxLatencyRatio) { *reason = QString("p95 latency %1 ms vs live %2 ms").arg(candP95, 0, 'f', 2).arg(liveP95, 0, 'f', 2); return false; }
+    if (cfg.maxLatencyMs > 0 && candP95 > cfg.maxLatencyMs) { *reason = QString("p95 latency %1 ms over %2 ms").arg(candP95, 0, 'f', 2).arg(cfg.maxLatencyMs); return false; }
+    if (agreement < cfg.minAgreement) { *reason = QString("agreement %1% below %2%").arg(agreement * 100, 0, 'f', 1).arg(cfg.minAgreement * 100, 0, 'f', 0); return false; }
+    if (cfg.maxMemoryKb > 0 && memoryKb > cfg.maxMemoryKb) { *reason = QString("uses %1 KB RSS, limit %2 KB").arg(memoryKb).arg(cfg.maxMemoryKb); return false; }
+    *reason = QString("p95 %1 ms (live %2 ms), agreement %3%").arg(candP95, 0, 'f', 2).arg(liveP95, 0, 'f', 2).arg(agreement * 100, 0, 'f', 1);
+    return true;
+}
+
+QJsonObject ShadowEvaluator::report() const {
+    QString reason; bool ok = passed(&reason);
+    return QJsonObject{
+        {"model", path}, {"started", (qint64)started}, {"finished", (qint64)VirtualClock::now()},
+        {"windows", windows}, {"agreement", windows > 0 ? (double)agreed / windows : 0.0},
+        {"live_p50_ms", percentile(liveLatency, 0.5)}, {"live_p95_ms", percentile(liveLatency, 0.95)},
+        {"candidate_p50_ms", percentile(candidateLatency, 0.5)}, {"candidate_p95_ms", percentile(candidateLatency, 0.95)},
+        {"candidate_max_ms", percentile(candidateLatency, 1.0)}, {"candidate_rss_kb", (qint64)memoryKb},
+        {"passed", ok}, {"reason", reason}
+    };
+}
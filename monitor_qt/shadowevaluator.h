@@ -0,0 +1,55 @@
+#ifndef SHADOWEVALUATOR_H
+#define SHADOWEVALUATOR_H
+
+#include <QString>
+#include <QVector>
+#include <QJsonObject>
+#include <memory>
+#include <time.h>
+
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/model.h"
+
+#include "monitorconfig.h"
+
+// Candidate model running next to the live interpreter on the same feature
+// windows. Records per-Invoke() latency of both models, the RSS cost of loading
+// the candidate and how often both pick the same label; passed() applies the
+// ShadowConfig gate once the evaluation period is over.
+class ShadowEvaluator
+{
+public:
+    ShadowEvaluator(const QString &modelPath, int batch, const ShadowConfig &cfg);
+
+    bool isValid() const { return error.isEmpty(); }
+    QString errorString() const { return error; }
+    QString modelPath() const { return path; }
+    // VmRSS of this process from /proc/self/statm
+    static long residentKb();
+
+    // features: rows x MODEL_INPUT_COUNT as given to the live model,
+    // liveLabels[row] = live top label or -1 if that row is not a real window
+    void evaluate(const float *features, int rows, const int *liveLabels, double liveMs);
+    bool isFinished(time_t now) const;
+    bool passed(QString *reason) const;
+    QJsonObject report() const;
+
+private:
+    QString path;
+    ShadowConfig cfg;
+    QString error;
+    time_t started;
+    long memoryKb = 0;
+
+    std::unique_ptr<tflite::FlatBufferModel> model;
+    std::unique_ptr<tflite::Interpreter> interpreter;
+
+    QVector<double> liveLatency;
+    QVector<double> candidateLatency;
+    int windows = 0;
+    int agreed = 0;
+
+    static double percentile(QVector<double> values, double p);
+};
+
+#endif // SHADOWEVALUATOR_H
@@ -0,0 +1,129 @@
+#!/bin/sh
+# Kiểm tra spool MQTT của monitor_daemon với một broker mosquitto cục bộ (máy dev / board):
+#  - daemon chạy 2 zone "sim" trên đồng hồ ảo, gửi telemetry tới broker ở 127.0.0.1
+#  - giữa chừng dừng broker: payload vào spool (nhiều segment 64 KB), bật lại: spool được
+#    drain theo thứ tự, segment đã ack hết thì bị xóa
+#  - so các seq nhận được với những gì daemon còn giữ trong spool lúc thoát: không được thiếu
+#    (trừ số payload daemon báo đã bỏ), phần drain phải đến theo thứ tự tăng dần;
+#    trùng lặp được phép (at least once)
+# Chạy 2 lượt: "spool" (mqtt_spool_kb đủ lớn, không mất gì, phải có rollover segment) và
+# "budget" (mqtt_spool_kb nhỏ: bỏ segment cũ nhất, số seq thiếu phải đúng số daemon báo).
+# Cần mosquitto, mosquitto_sub, monitor_daemon. Không chạy cạnh daemon thật: cùng socket /tmp/monitor_*.sock.
+# Usage: telemetry_spool_test.sh [model.tflite]   (biến môi trường: PORT, SPEED, HOURS, ONLINE_S, OFFLINE_S)
+
+MODEL=${1:-/mnt/data/model.tflite}
+DAEMON=${DAEMON:-monitor_daemon}
+PORT=${PORT:-18830}
+TOPIC=spooltest
+# 1000x: một payload (600 s ảo) mỗi 0.6 s thật, 30 giờ ảo = 108 s thật
+SPEED=${SPEED:-1000}
+HOURS=${HOURS:-30}
+ONLINE_S=${ONLINE_S:-15}
+OFFLINE_S=${OFFLINE_S:-40}
+DIR=/tmp/telemetry_spool_test
+
+BROKER=""; SUB=""; DPID=""
+cleanup() {
+    for p in $DPID $SUB $BROKER; do kill $p 2>/dev/null; done
+    wait 2>/dev/null
+}
+fail() { echo "telemetry_spool_test: $*" >&2; cleanup; exit 1; }
+trap 'cleanup; exit 1' INT TERM
+
+[ -f "$MODEL" ] || fail "model $MODEL not found"
+for c in mosquitto mosquitto_sub $DAEMON; do command -v $c >/dev/null || fail "$c not found"; done
+rm -rf $DIR
+
+# Persistence: phiên của mosquitto_sub (-c) còn nguyên sau khi broker khởi động lại,
+# nên payload đến trước khi subscriber kịp nối lại không bị mất ở phía broker
+start_broker() {
+    mosquitto -c $1/broker/mosquitto.conf >> $1/broker.log 2>&1 &
+    BROKER=$!
+    sleep 1
+    kill -0 $BROKER 2>/dev/null || fail "broker did not start (port $PORT in use?), see $1/broker.log"
+}
+stop_broker() { kill $BROKER; wait $BROKER 2>/dev/null; BROKER=""; }
+
+seqs() { sed -n 's/.*"seq":\([0-9]*\).*/\1/p'; }
+
+# run_phase <tên> <mqtt_spool_kb>
+run_phase() {
+    W=$DIR/$1
+    mkdir -p $W/data $W/broker
+    cat > $W/broker/mosquitto.conf <<EOF
+listener $PORT 127.0.0.1
+allow_anonymous true
+persistence true
+persistence_location $W/broker/
+EOF
+    cat > $W/zones.conf <<EOF
+Zone1 sim sim
+Zone2 sim sim
+mqtt_host=127.0.0.1
+mqtt_port=$PORT
+mqtt_topic=$TOPIC
+mqtt_publish_s=600
+mqtt_drain_per_s=20
+mqtt_spool_kb=$2
+EOF
+    start_broker $W
+    mosquitto_sub -h 127.0.0.1 -p $PORT -q 1 -c -i spool-test-$1 -t "$TOPIC/telemetry" > $W/received.jsonl 2>> $W/broker.log &
+    SUB=$!
+    sleep 1
+
+    MONITOR_ZONES=$W/zones.conf MONITOR_DATA_DIR=$W/data MONITOR_MODEL=$MODEL $DAEMON --speed $SPEED --hours $HOURS > $W/daemon.log 2>&1 &
+    DPID=$!
+    sleep $ONLINE_S
+    kill -0 $DPID 2>/dev/null || fail "$1: monitor_daemon exited early, see $W/daemon.log"
+    echo "$1: broker down for $OFFLINE_S s"
+    stop_broker
+    sleep $OFFLINE_S
+    SEGMENTS=$(ls $W/data/mqtt_spool 2>/dev/null | grep -c "^spool-.*\.jsonl$")
+    echo "$1: $SEGMENTS spool segment(s), broker up again"
+    start_broker $W
+    wait $DPID; DPID=""
+    # Drain xong từ lâu trước khi daemon thoát; chờ subscriber ghi nốt
+    sleep 2
+    kill $SUB; wait $SUB 2>/dev/null; SUB=""
+    stop_broker
+
+    seqs < $W/received.jsonl > $W/received.seq
+    cat $W/data/mqtt_spool/spool-*.jsonl 2>/dev/null | seqs > $W/spooled.seq
+    DROPPED=$(sed -n 's/.*spool over budget, dropped \([0-9]*\) payloads.*/\1/p' $W/daemon.log | tail -n 1)
+    DROPPED=${DROPPED:-0}
+
+    # Thứ tự nhận: payload gửi trực tiếp thì seq tăng dần; payload từ spool đến "muộn" (seq nhỏ hơn
+    # seq lớn nhất đã nhận) và phải tăng dần với nhau. Seq còn trong spool lúc thoát thì chưa gửi.
+    awk -v name=$1 -v dropped=$DROPPED -v leftfile=$W/spooled.seq '
+        BEGIN { max = -1; top = -1; lastLate = -1
+                while ((getline s < leftfile) > 0) { left[s + 0] = 1; spooled++; if (s + 0 > max) max = s + 0 } }
+        {
+            s = $1 + 0
+            if (s in seen) { dup++; next }
+            seen[s] = 1; n++
+            if (s in left) both++
+            if (s < top) { if (s <= lastLate) disorder++; lastLate = s; late++ } else top = s
+            if (s > max) max = s
+        }
+        END {
+            for (i = 0; i <= max; i++) if (!(i in seen) && !(i in left)) missing++
+            printf "%s: received %d payloads (seq 0..%d), %d duplicate(s), %d from the spool, %d left in the spool, %d missing, %d dropped by the daemon\n",
+                   name, n, max, dup, late, spooled, missing, dropped
+            bad = 0
+            if (n == 0) { print name ": nothing received"; bad = 1 }
+            if (late == 0) { print name ": nothing was drained from the spool"; bad = 1 }
+            if (disorder > 0) { print name ": spooled payloads arrived out of order"; bad = 1 }
+            if (both > 0) { print name ": " both " acknowledged payload(s) still in the spool"; bad = 1 }
+            if (missing != dropped) { print name ": " missing " payload(s) lost, daemon reported " dropped; bad = 1 }
+            exit bad
+        }' $W/received.seq || fail "$1 failed, logs in $W"
+}
+
+run_phase spool 4096
+[ "$SEGMENTS" -ge 2 ] || fail "spool: no segment rollover while offline (raise OFFLINE_S)"
+[ "$DROPPED" -eq 0 ] || fail "spool: $DROPPED payload(s) dropped under a 4 MB budget"
+
+run_phase budget 128
+[ "$DROPPED" -gt 0 ] || fail "budget: nothing dropped over mqtt_spool_kb=128 (raise OFFLINE_S)"
+
+echo "telemetry_spool_test: OK"
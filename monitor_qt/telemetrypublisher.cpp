@@ -0,0 +1,197 @@
+#include "telemetrypublisher.h"
+#include "virtualclock.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSysInfo>
+
+#include <algorithm>
+
+#include <mosquitto.h>
+
+// ---------------------------------------------------------------- PublishSpool
+
+PublishSpool::PublishSpool(const QString &dir, qint64 maxBytes) : dir(dir), maxBytes(maxBytes) {
+    QDir().mkpath(dir);
+    // Left over from the last run: drained first, in order
+    QStringList names = QDir(dir).entryList(QStringList() << "spool-*.jsonl", QDir::Files);
+    std::sort(names.begin(), names.end(), [](const QString &a, const QString &b) { return a.mid(6).section('.', 0, 0).toLongLong() < b.mid(6).section('.', 0, 0).toLongLong(); });
+    for (const QString &name : names) {
+        segments.append(QDir(dir).filePath(name)); bytes += QFileInfo(segments.last()).size();
+        nextSeq = qMax(nextSeq, name.mid(6).section('.', 0, 0).toLongLong() + 1);
+    }
+}
+
+void PublishSpool::append(const QByteArray &payload) {
+    QString last = segments.isEmpty() ? QString() : segments.last();
+    if (last.isEmpty() || last == draining || QFileInfo(last).size() + payload.size() + 1 > SPOOL_SEGMENT_BYTES) { last = QDir(dir).filePath(QString("spool-%1.jsonl").arg(nextSeq++)); segments.append(last); }
+    QFile file(last); if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) { qDebug() << "Publish spool: cannot write" << last; return; }
+    file.write(payload); file.write("\n"); file.close();
+    bytes += payload.size() + 1;
+    // Over budget: lose the oldest data, keep the newest
+    while (bytes > maxBytes && segments.size() > 1) {
+        QString oldest = segments.first() != draining ? segments.first() : segments[1];
+        if (oldest == last) break;
+        dropped += readSegment(oldest).size(); removeSegment(oldest);
+    }
+}
+
+QList<QByteArray> PublishSpool::readSegment(const QString &path) const {
+    QList<QByteArray> lines; QFile file(path);
+    if (file.open(QIODevice::ReadOnly)) for (const QByteArray &line : file.readAll().split('\n')) if (!line.isEmpty()) lines.append(line);
+    return lines;
+}
+
+void PublishSpool::removeSegment(const QString &path) {
+    if (!segments.contains(path)) return;
+    if (path == draining) draining.clear();
+    bytes -= QFileInfo(path).size(); QFile::remove(path); segments.removeAll(path);
+    if (bytes < 0 || segments.isEmpty()) bytes = 0;
+}
+
+// ---------------------------------------------------------------- TelemetryPublisher
+
+TelemetryPublisher::TelemetryPublisher(const PublishConfig &cfg, const QString &spoolDir, QObject *parent)
+    : QThread(parent), cfg(cfg), spoolDir(spoolDir)
+{
+    unit = QSysInfo::machineHostName();
+    if (this->cfg.topic.isEmpty()) this->cfg.topic = "monitor/" + unit;
+}
+
+TelemetryPublisher::~TelemetryPublisher() { stop(); }
+
+void TelemetryPublisher::stop() {
+    { QMutexLocker lock(&mutex); stopping = true; wake.wakeAll(); }
+    wait();
+}
+
+// Event loop side: O(1) under the mutex, no I/O
+void TelemetryPublisher::push(const Record &r) {
+    QMutexLocker lock(&mutex);
+    if (pending.size() >= PUBLISH_MAX_RECORDS) { pending.remove(0); droppedRecords++; }
+    pending.append(r);
+    if (r.kind == 'e') { flushNow = true; wake.wakeAll(); }
+}
+
+void TelemetryPublisher::addSample(int zone, qint64 timestamp, float temp, float hum, float lux) { push(Record{'s', zone, timestamp, temp, hum, lux}); }
+void TelemetryPublisher::addPrediction(int zone, qint64 timestamp, int label, float prob) { push(Record{'p', zone, timestamp, (float)label, prob, 0}); }
+void TelemetryPublisher::addEvent(int zone, qint64 timestamp, int label, float prob) { push(Record{'e', zone, timestamp, (float)label, prob, 0}); }
+
+static double round1(float v) { return qRound(v * 10) / 10.0; }
+static double round3(float v) { return qRound(v * 1000) / 1000.0; }
+
+QByteArray TelemetryPublisher::pack(const QVector<Record> &records) {
+    // Hand-written compact JSON: ~25 bytes per sample instead of ~90 for keyed objects
+    qint64 t0 = records.first().timestamp; for (const Record &r : records) t0 = qMin(t0, r.timestamp);
+    QByteArray s, p, e;
+    for (const Record &r : records) {
+        QByteArray item = "[" + QByteArray::number(r.zone) + "," + QByteArray::number(r.timestamp - t0) + ",";
+        if (r.kind == 's') s += (s.isEmpty() ? "" : ",") + item + QByteArray::number(round1(r.a)) + "," + QByteArray::number(round1(r.b)) + "," + QByteArray::number(round1(r.c)) + "]";
+        else (r.kind == 'p' ? p : e) += ((r.kind == 'p' ? p : e).isEmpty() ? "" : ",") + item + QByteArray::number((int)r.a) + "," + QByteArray::number(round3(r.b)) + "]";
+    }
+    return "{\"unit\":\"" + unit.toUtf8() + "\",\"seq\":" + QByteArray::number(seq++) + ",\"t\":" + QByteArray::number(t0) +
+           ",\"s\":[" + s + "],\"p\":[" + p + "],\"e\":[" + e + "]}";
+}
+
+bool TelemetryPublisher::publish(const QByteArray &payload, bool drain) {
+    if (!connected) return false;
+    int mid = 0; QByteArray topic = (cfg.topic + "/telemetry").toUtf8();
+    if (mosquitto_publish(mosq, &mid, topic.constData(), payload.size(), payload.constData(), 1, false) != MOSQ_ERR_SUCCESS) return false;
+    QMutexLocker lock(&ackMutex);
+    if (!earlyAcks.remove(mid)) (drain ? drainMids : liveMids).insert(mid);
+    return true;
+}
+
+void TelemetryPublisher::drainSome(PublishSpool *spool, int budget) {
+    if (drainSegment.isEmpty()) { drainSegment = spool->beginDrain(); drainLines = spool->readSegment(drainSegment); drainNext = 0; }
+    // Keep the broker link from filling with backlog while it flaps
+    { QMutexLocker lock(&ackMutex); if (drainMids.size() >= 2 * cfg.drainPerS) return; }
+    while (budget-- > 0 && drainNext < drainLines.size() && publish(drainLines[drainNext], true)) drainNext++;
+    // QoS 1 messages in flight survive reconnects inside libmosquitto; the file goes once all are acknowledged
+    bool done; { QMutexLocker lock(&ackMutex); done = drainNext >= drainLines.size() && drainMids.isEmpty(); }
+    if (done) { spool->removeSegment(drainSegment); drainSegment.clear(); drainLines.clear(); }
+}
+
+void TelemetryPublisher::onConnect(struct mosquitto *mosq, void *self, int rc) {
+    TelemetryPublisher *p = static_cast<TelemetryPublisher *>(self);
+    if (rc != 0) { qDebug() << "MQTT: connect refused:" << mosquitto_connack_string(rc); return; }
+    QByteArray topic = (p->cfg.topic + "/status").toUtf8();
+    int mid = 0;
+    if (mosquitto_publish(mosq, &mid, topic.constData(), 6, "online", 1, true) == MOSQ_ERR_SUCCESS) { QMutexLocker lock(&p->ackMutex); p->liveMids.insert(mid); }
+    p->connected = true;
+    QMutexLocker lock(&p->mutex); p->wake.wakeAll();
+}
+
+void TelemetryPublisher::onDisconnect(struct mosquitto *, void *self, int rc) {
+    TelemetryPublisher *p = static_cast<TelemetryPublisher *>(self);
+    if (p->connected && rc != 0) qDebug() << "MQTT: connection lost, spooling";
+    p->connected = false;
+}
+
+void TelemetryPublisher::onPublish(struct mosquitto *, void *self, int mid) {
+    TelemetryPublisher *p = static_cast<TelemetryPublisher *>(self);
+    QMutexLocker lock(&p->ackMutex);
+    if (!p->drainMids.remove(mid) && !p->liveMids.remove(mid)) p->earlyAcks.insert(mid);
+}
+
+void TelemetryPublisher::run() {
+    mosquitto_lib_init();
+    QByteArray clientId = ("monitor-" + unit).toUtf8(), host = cfg.host.toUtf8(), statusTopic = (cfg.topic + "/status").toUtf8();
+    mosq = mosquitto_new(clientId.constData(), true, this);
+    if (!mosq) { qDebug() << "MQTT: cannot create client"; mosquitto_lib_cleanup(); return; }
+    mosquitto_connect_callback_set(mosq, &TelemetryPublisher::onConnect);
+    mosquitto_disconnect_callback_set(mosq, &TelemetryPublisher::onDisconnect);
+    mosquitto_publish_callback_set(mosq, &TelemetryPublisher::onPublish);
+    mosquitto_will_set(mosq, statusTopic.constData(), 7, "offline", 1, true);
+    if (!cfg.user.isEmpty()) mosquitto_username_pw_set(mosq, cfg.user.toUtf8().constData(), cfg.password.isEmpty() ? nullptr : cfg.password.toUtf8().constData());
+    mosquitto_reconnect_delay_set(mosq, 2, 60, true);
+    // Network I/O and reconnects on libmosquitto's own thread; this one only packs, spools and paces
+    bool connectIssued = mosquitto_connect_async(mosq, host.constData(), cfg.port, MQTT_KEEPALIVE_S) == MOSQ_ERR_SUCCESS;
+    mosquitto_loop_start(mosq);
+    qInfo().noquote() << QString("MQTT: publishing to %1:%2 %3/telemetry every %4 s").arg(cfg.host).arg(cfg.port).arg(cfg.topic).arg(cfg.intervalS);
+
+    PublishSpool spool(spoolDir, (qint64)cfg.spoolKb * 1024);
+    QElapsedTimer clock; clock.start();
+    qint64 nextPublish = VirtualClock::interval(cfg.intervalS * 1000), lastConnectTry = 0, reportedDrops = 0;
+
+    QMutexLocker lock(&mutex);
+    while (!stopping) {
+        qint64 now = clock.elapsed();
+        bool backlog = connected && (!spool.isEmpty() || !drainSegment.isEmpty());
+        qint64 waitMs = qMin(nextPublish - now, backlog ? (qint64)1000 : nextPublish - now);
+        if (!flushNow && waitMs > 0) wake.wait(&mutex, waitMs);
+        if (stopping) break;
+        now = clock.elapsed();
+
+        if (flushNow || now >= nextPublish) {
+            QVector<Record> batch; batch.swap(pending); flushNow = false;
+            qint64 drops = droppedRecords;
+            lock.unlock();
+            if (drops > reportedDrops) { qDebug() << "MQTT: dropped" << drops - reportedDrops << "records (publisher behind)"; reportedDrops = drops; }
+            if (!batch.isEmpty()) { QByteArray payload = pack(batch); if (!publish(payload, false)) spool.append(payload); }
+            lock.relock();
+            if (now >= nextPublish) nextPublish = now + VirtualClock::interval(cfg.intervalS * 1000);
+        }
+
+        if (connected && (!spool.isEmpty() || !drainSegment.isEmpty())) {
+            // Rate-limited catch-up, so a day offline does not flood the broker (or the link) at once
+            lock.unlock(); drainSome(&spool, cfg.drainPerS); lock.relock();
+        }
+        if (!connectIssued && clock.elapsed() - lastConnectTry > MQTT_RETRY_S * 1000) {
+            // Broker unresolvable/unreachable at start: libmosquitto only retries a connect that got started
+            lastConnectTry = clock.elapsed();
+            lock.unlock(); connectIssued = mosquitto_connect_async(mosq, host.constData(), cfg.port, MQTT_KEEPALIVE_S) == MOSQ_ERR_SUCCESS; lock.relock();
+        }
+    }
+
+    // Shutdown: whatever was not sent yet goes to the spool for the next run
+    QVector<Record> batch; batch.swap(pending); lock.unlock();
+    if (!batch.isEmpty()) spool.append(pack(batch));
+    if (spool.droppedPayloads() > 0) qDebug() << "MQTT: spool over budget, dropped" << spool.droppedPayloads() << "payloads";
+    if (connected) mosquitto_publish(mosq, nullptr, statusTopic.constData(), 7, "offline", 1, true);
+    mosquitto_disconnect(mosq); mosquitto_loop_stop(mosq, false);
+    mosquitto_destroy(mosq); mosq = nullptr;
+    mosquitto_lib_cleanup();
+}
@@ -0,0 +1,117 @@
+#ifndef TELEMETRYPUBLISHER_H
+#define TELEMETRYPUBLISHER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <atomic>
+
+#include "monitorconfig.h"
+
+#define SPOOL_SEGMENT_BYTES  (64 * 1024)
+#define PUBLISH_MAX_RECORDS  20000     // in-memory cap if the thread falls behind (oldest dropped)
+#define MQTT_KEEPALIVE_S     30
+#define MQTT_RETRY_S         30
+
+struct mosquitto;
+
+// Bounded on-disk queue of payloads: "spool-<seq>.jsonl" segments of one
+// payload per line, the oldest segments deleted when over maxBytes.
+class PublishSpool
+{
+public:
+    PublishSpool(const QString &dir, qint64 maxBytes);
+
+    void append(const QByteArray &payload);
+    bool isEmpty() const { return segments.isEmpty(); }
+    qint64 size() const { return bytes; }
+    qint64 droppedPayloads() const { return dropped; }
+
+    // Oldest segment, read whole (<= SPOOL_SEGMENT_BYTES) by the drainer; nothing is
+    // appended to it from then on, and it is removed once every line is acknowledged
+    QString beginDrain() { draining = segments.isEmpty() ? QString() : segments.first(); return draining; }
+    QList<QByteArray> readSegment(const QString &path) const;
+    void removeSegment(const QString &path);
+
+private:
+    QString dir;
+    qint64 maxBytes;
+    qint64 bytes = 0, dropped = 0;
+    QStringList segments;   // oldest first
+    QString draining;
+    qint64 nextSeq = 0;
+};
+
+// Live telemetry to an MQTT broker (libmosquitto). The event loop only appends
+// records under a mutex (addSample/addPrediction/addEvent); this thread packs
+// them every PublishConfig::intervalS into one compact JSON payload:
+//   {"unit":..,"seq":..,"t":<first epoch s>,"s":[[zone,dt,temp,hum,lux]..],
+//    "p":[[zone,dt,label,prob]..],"e":[[zone,dt,label,prob]..]}
+// (dt = seconds after t) and publishes it at QoS 1 to <topic>/telemetry. An
+// event flushes the batch right away. Offline, payloads go to the spool and
+// are drained oldest first at drainPerS once connected again, at least once:
+// a segment is deleted only when every line of it is acknowledged. After a
+// disconnect the drain resumes where it stopped (libmosquitto resends the QoS 1
+// messages still in flight); after a restart the whole segment is sent again.
+// <topic>/status is "online" (retained), "offline" as the will.
+// telemetry_spool_test.sh checks the spool against a local mosquitto.
+class TelemetryPublisher : public QThread
+{
+public:
+    TelemetryPublisher(const PublishConfig &cfg, const QString &spoolDir, QObject *parent = nullptr);
+    ~TelemetryPublisher();
+
+    void stop();
+
+    void addSample(int zone, qint64 timestamp, float temp, float hum, float lux);
+    void addPrediction(int zone, qint64 timestamp, int label, float prob);
+    void addEvent(int zone, qint64 timestamp, int label, float prob);
+
+protected:
+    void run() override;
+
+private:
+    struct Record { char kind; int zone; qint64 timestamp; float a, b, c; };
+
+    PublishConfig cfg;
+    QString spoolDir;
+    QString unit;
+
+    // Shared with the event loop
+    QMutex mutex;
+    QWaitCondition wake;
+    QVector<Record> pending;
+    qint64 droppedRecords = 0;
+    bool stopping = false;
+    bool flushNow = false;
+
+    // Shared with the libmosquitto network thread. A PUBACK can arrive before
+    // publish() returns the mid to us, hence earlyAcks.
+    std::atomic<bool> connected{false};
+    QMutex ackMutex;
+    QSet<int> liveMids, drainMids, earlyAcks;
+
+    struct mosquitto *mosq = nullptr;
+    qint64 seq = 0;
+
+    // Spool segment being drained
+    QString drainSegment;
+    QList<QByteArray> drainLines;
+    int drainNext = 0;
+
+    void push(const Record &r);
+    QByteArray pack(const QVector<Record> &records);
+    bool publish(const QByteArray &payload, bool drain);
+    void drainSome(PublishSpool *spool, int budget);
+
+    static void onConnect(struct mosquitto *mosq, void *self, int rc);
+    static void onDisconnect(struct mosquitto *mosq, void *self, int rc);
+    static void onPublish(struct mosquitto *mosq, void *self, int mid);
+};
+
+#endif // TELEMETRYPUBLISHER_H
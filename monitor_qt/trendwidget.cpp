@@ -0,0 +1,102 @@
+#include "trendwidget.h"
+#include <QPainter>
+#include <QDateTime>
+#include <float.h>
+
+#define TREND_BG    QColor("#2B2B2B")
+#define TREND_GRID  QColor("#444444")
+#define TREND_TEXT  QColor("#AAAAAA")
+
+TrendWidget::TrendWidget(QWidget *parent) : QWidget(parent)
+{
+    setMinimumHeight(140);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void TrendWidget::setSeries(const QVector<TrendPoint> &series, int periodS, int slots, const QString &unit, const QColor &color) {
+    this->periodS = periodS; this->slots = slots; this->unit = unit; this->color = color;
+    points = series.size() > slots ? series.mid(series.size() - slots) : series;
+    firstSlot = points.isEmpty() ? 0 : slotOf(points.last()) - slots + 1;
+    fitRange(); redraw();
+}
+
+void TrendWidget::clear() { points.clear(); redraw(); }
+
+void TrendWidget::append(const TrendPoint &p) {
+    if (!points.isEmpty() && slotOf(p) <= slotOf(points.last())) return;   // already in the series
+    bool first = points.isEmpty();
+    points.append(p); if (points.size() > slots) points.removeFirst();
+    if (first) { firstSlot = slotOf(p) - slots + 1; fitRange(); redraw(); return; }
+    if (!fitsRange(p)) { fitRange(); redraw(); return; }
+    if (plot.isNull()) return;   // not laid out yet, resizeEvent() draws everything
+
+    qint64 slot = slotOf(p); int dx = 0;
+    if (slot >= firstSlot + slots) {
+        // Scroll left by at least a quarter of the width, then only draw into the freed strip
+        qint64 shift = qMax((qint64)qMax(1, slots / 4), slot - (firstSlot + slots) + 1);
+        if (shift >= slots) { firstSlot = slot - slots + 1; redraw(); return; }
+        dx = qRound(shift * (double)plot.width() / slots);
+        plot.scroll(-dx, 0, plot.rect()); firstSlot += shift;
+    }
+    QPainter painter(&plot); painter.setRenderHint(QPainter::Antialiasing);
+    if (dx > 0) drawGrid(painter, QRectF(plot.width() - dx, 0, dx, plot.height()));
+    drawSegment(painter, points.size() - 1);
+    painter.end();
+    update();
+}
+
+float TrendWidget::xOf(qint64 slot) const { return (slot - firstSlot + 0.5f) * plot.width() / slots; }
+float TrendWidget::yOf(float v) const { return plot.height() - 6 - (v - yMin) / (yMax - yMin) * (plot.height() - 12); }
+
+// y range from the data with 10% headroom, so small excursions do not force a full redraw
+void TrendWidget::fitRange() {
+    float lo = FLT_MAX, hi = -FLT_MAX;
+    for (const TrendPoint &p : points) { if (p.min < lo) lo = p.min; if (p.max > hi) hi = p.max; }
+    if (points.isEmpty()) { lo = 0; hi = 1; }
+    float pad = qMax((hi - lo) * 0.1f, 0.5f);
+    yMin = lo - pad; yMax = hi + pad;
+}
+
+void TrendWidget::redraw() {
+    if (width() <= 0 || height() <= 0) return;
+    plot = QPixmap(size());
+    QPainter painter(&plot); painter.setRenderHint(QPainter::Antialiasing);
+    drawGrid(painter, plot.rect());
+    for (int i = 0; i < points.size(); i++) if (slotOf(points[i]) >= firstSlot) drawSegment(painter, i);
+    painter.end();
+    update();
+}
+
+void TrendWidget::drawGrid(QPainter &painter, const QRectF &area) {
+    painter.save(); painter.setClipRect(area);
+    painter.fillRect(area, TREND_BG);
+    painter.setPen(QPen(TREND_GRID, 1, Qt::DotLine));
+    for (int i = 1; i < 4; i++) { float y = plot.height() * i / 4.0f; painter.drawLine(QPointF(area.left(), y), QPointF(area.right(), y)); }
+    painter.restore();
+}
+
+// Band from min to max of bucket i, plus the mean line joining the previous bucket if adjacent
+void TrendWidget::drawSegment(QPainter &painter, int i) {
+    const TrendPoint &p = points[i]; qint64 slot = slotOf(p); float x = xOf(slot);
+    QColor band = color; band.setAlpha(90);
+    painter.setPen(QPen(band, qMax(1.0, (double)plot.width() / slots), Qt::SolidLine, Qt::FlatCap));
+    painter.drawLine(QPointF(x, yOf(p.min)), QPointF(x, yOf(p.max)));
+    painter.setPen(QPen(color, 2));
+    if (i > 0 && slotOf(points[i - 1]) == slot - 1) painter.drawLine(QPointF(xOf(slot - 1), yOf(points[i - 1].mean)), QPointF(x, yOf(p.mean)));
+    else painter.drawPoint(QPointF(x, yOf(p.mean)));
+}
+
+void TrendWidget::paintEvent(QPaintEvent *) {
+    QPainter painter(this);
+    if (plot.isNull()) { painter.fillRect(rect(), TREND_BG); return; }
+    painter.drawPixmap(0, 0, plot);
+    // Axis labels stay outside the pixmap so scrolling never smears them
+    painter.setPen(TREND_TEXT);
+    if (points.isEmpty()) { painter.drawText(rect(), Qt::AlignCenter, "No data yet"); return; }
+    painter.drawText(rect().adjusted(4, 2, -4, -2), Qt::AlignLeft | Qt::AlignTop, QString::number(yMax, 'f', 1) + " " + unit);
+    painter.drawText(rect().adjusted(4, 2, -4, -2), Qt::AlignLeft | Qt::AlignBottom, QString::number(yMin, 'f', 1) + " " + unit);
+    QString fmt = periodS >= 86400 ? "dd/MM" : (periodS >= 3600 ? "dd/MM HH:mm" : "HH:mm");
+    painter.drawText(rect().adjusted(4, 2, -4, -2), Qt::AlignRight | Qt::AlignBottom, QDateTime::fromSecsSinceEpoch(points.last().start).toString(fmt));
+}
+
+void TrendWidget::resizeEvent(QResizeEvent *) { redraw(); }
@@ -0,0 +1,57 @@
+#ifndef TRENDWIDGET_H
+#define TRENDWIDGET_H
+
+#include <QWidget>
+#include <QPixmap>
+#include <QVector>
+#include <QColor>
+
+// One rollup bucket of the selected sensor
+struct TrendPoint {
+    qint64 start;
+    float min;
+    float max;
+    float mean;
+};
+
+// Min/max band + mean line over a fixed number of buckets.
+// The plot lives in a pixmap: appending a bucket only draws the new segment,
+// reaching the right edge scrolls the pixmap by a quarter of the width.
+// A full redraw happens only on resize, new series or a value outside the y range.
+class TrendWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit TrendWidget(QWidget *parent = nullptr);
+
+    // periodS: bucket length, slots: buckets across the width
+    void setSeries(const QVector<TrendPoint> &points, int periodS, int slots, const QString &unit, const QColor &color);
+    void append(const TrendPoint &p);
+    void clear();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    QVector<TrendPoint> points;
+    QPixmap plot;
+    int periodS = 60;
+    int slots = 60;
+    qint64 firstSlot = 0;   // bucket number at the left edge
+    float yMin = 0, yMax = 1;
+    QString unit;
+    QColor color;
+
+    qint64 slotOf(const TrendPoint &p) const { return (p.start + periodS / 2) / periodS; }
+    float xOf(qint64 slot) const;
+    float yOf(float v) const;
+    bool fitsRange(const TrendPoint &p) const { return p.min >= yMin && p.max <= yMax; }
+    void fitRange();
+    void redraw();
+    void drawGrid(QPainter &painter, const QRectF &area);
+    void drawSegment(QPainter &painter, int i);
+};
+
+#endif // TRENDWIDGET_H
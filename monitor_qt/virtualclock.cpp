@@ -0,0 +1,25 @@
+#include "virtualclock.h"
+#include <QElapsedTimer>
+#include <QDateTime>
+
+static double clockSpeed = 1.0;
+static qint64 clockBaseMs = 0;
+static QElapsedTimer clockTimer;
+
+void VirtualClock::start(double speed, qint64 startSecs) {
+    clockSpeed = speed > 0 ? speed : 1.0;
+    clockBaseMs = startSecs * 1000;
+    clockTimer.start();
+}
+
+bool VirtualClock::isVirtual() { return clockTimer.isValid(); }
+double VirtualClock::speed() { return clockSpeed; }
+
+qint64 VirtualClock::nowMs() {
+    if (!clockTimer.isValid()) return QDateTime::currentMSecsSinceEpoch();
+    return clockBaseMs + (qint64)(clockTimer.elapsed() * clockSpeed);
+}
+
+time_t VirtualClock::now() { return clockTimer.isValid() ? (time_t)(nowMs() / 1000) : time(NULL); }
+
+int VirtualClock::interval(int virtualMs) { return qMax(1, (int)(virtualMs / clockSpeed)); }
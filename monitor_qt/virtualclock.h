@@ -0,0 +1,25 @@
+#ifndef VIRTUALCLOCK_H
+#define VIRTUALCLOCK_H
+
+#include <QtGlobal>
+#include <time.h>
+
+// Time source of the monitoring loop. Normally the wall clock; for soak and
+// load tests (monitor_daemon --speed N) it starts at a chosen epoch and runs N
+// times faster, and every timer period of the core is divided by N, so a day
+// of sampling, logging, rotation and inference takes 86.4 s at 1000x.
+class VirtualClock
+{
+public:
+    // Call before MonitorCore::start() (threads read the clock without locking)
+    static void start(double speed, qint64 startSecs);
+    static bool isVirtual();
+    static double speed();
+
+    static time_t now();
+    static qint64 nowMs();
+    // Real timer period for a period given in virtual milliseconds (>= 1 ms)
+    static int interval(int virtualMs);
+};
+
+#endif // VIRTUALCLOCK_H
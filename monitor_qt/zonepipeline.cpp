@@ -0,0 +1,141 @@
+#include "zonepipeline.h"
+#include <QDebug>
+#include <QDateTime>
+#include <QDir>
+
+// C System Headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <math.h>
+#include <float.h>
+#include <string.h>
+
+ZonePipeline::ZonePipeline(const ZoneConfig &cfg, int index) : cfg(cfg), index(index), rollup(cfg.dataDir), dhtSource(SensorSource::create(cfg.dhtDev, SENSOR_DHT11, index)), bhSource(SensorSource::create(cfg.bhDev, SENSOR_BH1750, index))
+{
+    QDir().mkpath(cfg.dataDir);
+
+    // Init sensor backup values
+    lastValidTemp = 25.0f;
+    lastValidHum = 60.0f;
+    lastValidLux = 100.0f;
+    reset();
+}
+
+void ZonePipeline::reset() {
+    buffer_head = 0; samples_collected = 0;
+    for(int i=0; i<WINDOW_LEN; i++) for(int j=0; j<RAW_FEATURE_COUNT; j++) input_buffer[i][j] = 0.0f;
+    dataBuffer.clear(); cooldownTimer = 0;
+    lastPredictionIdx = 0; // Reset last prediction to Normal
+}
+
+void ZonePipeline::setDecimationMode(DecimationMode mode) {
+    QMutexLocker lock(&sampleMutex);
+    tempDecimator.setMode(mode); humDecimator.setMode(mode); luxDecimator.setMode(mode);
+}
+
+bool ZonePipeline::sampleDHT11(time_t now) {
+    SensorSample samples[SENSOR_BATCH_MAX]; int n = dhtSource->readTimed(SENSOR_DHT11, now, samples, SENSOR_BATCH_MAX);
+    if (n < 0) return false;
+    int valid = 0; QMutexLocker lock(&sampleMutex);
+    for (int i = 0; i < n; i++) if (samples[i].temp != 0 && samples[i].humid != 0) { tempDecimator.push(samples[i].temp); humDecimator.push(samples[i].humid); valid++; }
+    return n == 0 || valid > 0;   // 0: buffered backend, nothing new yet
+}
+
+bool ZonePipeline::sampleBH1750(time_t now) {
+    SensorSample samples[SENSOR_BATCH_MAX]; int n = bhSource->readTimed(SENSOR_BH1750, now, samples, SENSOR_BATCH_MAX);
+    if (n < 0) return false;
+    QMutexLocker lock(&sampleMutex);
+    for (int i = 0; i < n; i++) luxDecimator.push(samples[i].lux);
+    return true;
+}
+
+void ZonePipeline::decimate(time_t now) {
+    // 1. READ SENSOR (single shot only if the sensor timers delivered nothing this interval)
+    if (fallbackReads) {
+        bool noTemp, noLux; { QMutexLocker lock(&sampleMutex); noTemp = tempDecimator.count() == 0; noLux = luxDecimator.count() == 0; }
+        if (noTemp) sampleDHT11(now);
+        if (noLux) sampleBH1750(now);
+    }
+
+    QMutexLocker lock(&sampleMutex);
+    float temp, hum, lux;
+    if (tempDecimator.reduce(&temp) && humDecimator.reduce(&hum)) {
+        lastValidTemp = temp;
+        lastValidHum = hum;
+    } else {
+        qDebug() << cfg.name << "Sensor Error or Zero Detected! Using Last Known Values.";
+    }
+
+    if (luxDecimator.reduce(&lux)) lastValidLux = lux;
+}
+
+void ZonePipeline::record(time_t now) {
+    float finalTemp = lastValidTemp;
+    float finalHumid = lastValidHum;
+    float finalLux = lastValidLux;
+
+    // 2. PREPARE DATA
+    BufferedSample sample; sample.timestamp = (long)now; sample.temp = finalTemp; sample.humid = finalHumid; sample.lux = finalLux; sample.label = "normal";
+    float all_feats[9]; calcTimeFeatures(now, all_feats); all_feats[6] = finalTemp; all_feats[7] = finalHumid; all_feats[8] = finalLux; memcpy(sample.features, all_feats, sizeof(float)*9);
+    dataBuffer.append(sample);
+
+    // 3. DETECT EVENTS
+    if (dataBuffer.size() > DETECTION_WINDOW && cooldownTimer == 0) {
+        int currentIdx = dataBuffer.size() - 1;
+        int pastIdx = currentIdx - DETECTION_WINDOW;
+
+        float avgTempCurrent = (dataBuffer[currentIdx].temp + dataBuffer[currentIdx-1].temp + dataBuffer[currentIdx-2].temp) / 3.0f;
+        float avgTempPast = (dataBuffer[pastIdx].temp + dataBuffer[pastIdx+1].temp + dataBuffer[pastIdx+2].temp) / 3.0f;
+
+        float avgHumidCurrent = (dataBuffer[currentIdx].humid + dataBuffer[currentIdx-1].humid + dataBuffer[currentIdx-2].humid) / 3.0f;
+        float avgHumidPast = (dataBuffer[pastIdx].humid + dataBuffer[pastIdx+1].humid + dataBuffer[pastIdx+2].humid) / 3.0f;
+
+        float deltaTemp = avgTempCurrent - avgTempPast;
+        float deltaHumid = avgHumidCurrent - avgHumidPast;
+
+        QString detectedEvent = "";
+
+        if (deltaTemp >= THRESHOLD_TEMP_RISE) {
+            if (deltaHumid >= THRESHOLD_HUMID_RISE) detectedEvent = "temp_inc, humid_inc";
+            else if (deltaHumid <= THRESHOLD_HUMID_DROP) detectedEvent = "temp_inc, humid_dec";
+        }
+
+        if (!detectedEvent.isEmpty()) {
+            // Relabel Backwards
+            int labelEndIdx = pastIdx; int labelStartIdx = labelEndIdx - PREDICTION_OFFSET; if (labelStartIdx < 0) labelStartIdx = 0;
+            for (int i = labelStartIdx; i <= labelEndIdx; i++) if (dataBuffer[i].label == "normal") dataBuffer[i].label = detectedEvent;
+
+            cooldownTimer = 90;
+        }
+    } else { if (cooldownTimer > 0) cooldownTimer--; }
+
+    // 4. FLUSH TO DISK
+    while (dataBuffer.size() > BUFFER_MAX_SIZE) {
+        BufferedSample toWrite = dataBuffer.takeFirst();
+        QDateTime currentDT = QDateTime::fromTime_t(toWrite.timestamp); QString todayFileName = currentDT.toString("yyyy-MM-dd") + ".csv"; QString todayFullLink = QString("%1/%2").arg(cfg.dataDir).arg(todayFileName);
+        QByteArray fileNameBytes = todayFullLink.toLocal8Bit(); FILE *fp = fopen(fileNameBytes.constData(), "a");
+        if (fp) {
+             if (ftell(fp) == 0) fprintf(fp, "timestamp,min_sin,min_cos,temp,humid,lux,label\n");
+             fprintf(fp, "%ld,%.5f,%.5f,%.1f,%.1f,%.1f,%s\n", toWrite.timestamp * 1000, toWrite.features[0], toWrite.features[1], toWrite.features[6], toWrite.features[7], toWrite.features[8], toWrite.label.toStdString().c_str());
+             fclose(fp);
+        }
+        rollup.addLabel(toWrite.timestamp, toWrite.label);
+    }
+
+    // 5. MODEL WINDOW
+    float raw_input[RAW_FEATURE_COUNT]; raw_input[0] = all_feats[0]; raw_input[1] = all_feats[1]; raw_input[2] = all_feats[6]; raw_input[3] = all_feats[7]; raw_input[4] = all_feats[8];
+    buffer_head = (buffer_head + 1) % WINDOW_LEN; for(int k=0; k<RAW_FEATURE_COUNT; k++) input_buffer[buffer_head][k] = raw_input[k];
+    samples_collected++;
+}
+
+void ZonePipeline::computeFeatures(float *processed_input) const {
+    // Unroll the ring buffer (oldest first) into columns for the shared feature kernel
+    float columns[RAW_FEATURE_COUNT][WINDOW_LEN]; const float *cols[RAW_FEATURE_COUNT];
+    for (int i = 0; i < WINDOW_LEN; i++) { int buf_idx = (buffer_head + 1 + i) % WINDOW_LEN; for (int col = 0; col < RAW_FEATURE_COUNT; col++) columns[col][i] = input_buffer[buf_idx][col]; }
+    for (int col = 0; col < RAW_FEATURE_COUNT; col++) cols[col] = columns[col];
+    extractFeaturesBatch(cols, 1, 1, processed_input);
+}
+
+void ZonePipeline::calcTimeFeatures(time_t t, float *features) { struct tm *tm_info = localtime(&t); float min_of_day = tm_info->tm_hour * 60.0 + tm_info->tm_min; features[0] = sin(2 * M_PI * min_of_day / 1440.0); features[1] = cos(2 * M_PI * min_of_day / 1440.0); features[2] = sin(2 * M_PI * tm_info->tm_wday / 7.0); features[3] = cos(2 * M_PI * tm_info->tm_wday / 7.0); features[4] = sin(2 * M_PI * tm_info->tm_yday / 366.0); features[5] = cos(2 * M_PI * tm_info->tm_yday / 366.0); }
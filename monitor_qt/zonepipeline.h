@@ -0,0 +1,111 @@
+#ifndef ZONEPIPELINE_H
+#define ZONEPIPELINE_H
+
+#include <QString>
+#include <QList>
+#include <QMutex>
+#include <time.h>
+
+#include "decimator.h"
+#include "rollupstore.h"
+#include "featurekernels.h"   // RAW_FEATURE_COUNT, MODEL_INPUT_COUNT, WINDOW_LEN, MA_WINDOW
+#include "sensorsource.h"
+#include "monitorconfig.h"
+#include <memory>
+
+#define BUFFER_MAX_SIZE 180
+#define PREDICTION_OFFSET 90
+#define DETECTION_WINDOW 10
+#define THRESHOLD_TEMP_RISE 0.4
+#define THRESHOLD_HUMID_RISE 2.0
+#define THRESHOLD_HUMID_DROP -2.0
+
+struct BufferedSample {
+    long timestamp;
+    float features[9];
+    float temp;
+    float humid;
+    float lux;
+    QString label;
+};
+
+// Acquisition, feature window, event labeling and CSV logging state of one zone.
+// Holds no UI and no model: MainWindow packs the windows of all zones into one batch.
+class ZonePipeline
+{
+public:
+    ZonePipeline(const ZoneConfig &cfg, int index);
+
+    const ZoneConfig &config() const { return cfg; }
+    void reset();
+
+    void setDecimationMode(DecimationMode mode);
+    // Oversampling: each sensor is read at its own rate, valid readings are queued
+    // (all of them for batched backends). May run on the real-time sampler thread;
+    // false if the read failed or gave nothing usable.
+    bool sampleDHT11(time_t now);
+    bool sampleBH1750(time_t now);
+    // Reduce the queued readings to one value per channel (model cadence),
+    // keep last valid values if a sensor produced nothing usable
+    void decimate(time_t now);
+    // Off when a sampler thread owns the sensors: decimate() then never reads them itself
+    void setFallbackReads(bool on) { fallbackReads = on; }
+    // Buffer sample, detect events, flush old samples to CSV, push model window
+    void record(time_t now);
+
+    bool isWindowReady() const { return samples_collected >= WINDOW_LEN; }
+    int samplesCollected() const { return samples_collected; }
+    // avg/min/max/MA6 of each raw column over the window -> MODEL_INPUT_COUNT floats
+    void computeFeatures(float *processed_input) const;
+
+    // Backends in use, for the per-read cost report
+    const SensorSource *dhtSensor() const { return dhtSource.get(); }
+    const SensorSource *bhSensor() const { return bhSource.get(); }
+
+    // Samples not yet flushed to CSV (labels may still change), for HeadTrainer
+    const QList<BufferedSample> &bufferedSamples() const { return dataBuffer; }
+
+    // Minute/hour/day summaries, fed by MonitorCore and by the CSV flush (labels)
+    ZoneRollup &rollups() { return rollup; }
+
+    float temp() const { return lastValidTemp; }
+    float humid() const { return lastValidHum; }
+    float lux() const { return lastValidLux; }
+
+    int lastPredictionIdx = 0;
+
+    static void calcTimeFeatures(time_t t, float *features);
+
+private:
+    ZoneConfig cfg;
+    int index;
+
+    // AI Logic
+    float input_buffer[WINDOW_LEN][RAW_FEATURE_COUNT];
+    int buffer_head = 0;
+    int samples_collected = 0;
+
+    // Data Buffer
+    QList<BufferedSample> dataBuffer;
+    int cooldownTimer = 0;
+
+    ZoneRollup rollup;
+
+    // Readings queued since the last model tick (sampleMutex: pushed from the sampler thread)
+    QMutex sampleMutex;
+    bool fallbackReads = true;
+    Decimator tempDecimator;
+    Decimator humDecimator;
+    Decimator luxDecimator;
+
+    // Sensor Last Known Values
+    float lastValidTemp;
+    float lastValidHum;
+    float lastValidLux;
+
+    // Sensor HAL backend per the zone's device strings
+    std::unique_ptr<SensorSource> dhtSource;
+    std::unique_ptr<SensorSource> bhSource;
+};
+
+#endif // ZONEPIPELINE_H
@@ -0,0 +1,245 @@
+// Latency / jitter benchmark for the /dev/dht11-N and /dev/bh1750 drivers.
+// Each reader thread does what monitor_daemon does (open, read, close) at a fixed
+// rate and records the latency and outcome of every read, optionally while other
+// threads generate CPU, interrupt and I/O load. Works the same on real sensors
+// and on i2c-stub / gpio-sim (see sensor_bench_sim.sh).
+//
+// Usage: sensor_bench [-d dev]... [-r rate] [-t threads] [-n seconds]
+//                     [-c cpu] [-i irq] [-o io] [-T dir]
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <libgen.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#define MAX_DEVICES   8
+#define MAX_THREADS   64
+#define MAX_CODES     32
+#define DEFAULT_DHT   "/dev/dht11-0"
+#define DEFAULT_BH    "/dev/bh1750"
+#define DHT_SYSFS     "/sys/class/dht11_class/%s/irq_off_%s_us"
+#define IO_CHUNK      (256 * 1024)
+
+enum DevKind { DEV_DHT11, DEV_BH1750 };
+
+// Outcome of one read: "ok", "dht -N" (driver error code), "read EIO", "open ENOENT", "parse"
+struct CodeCount { char code[24]; long count; };
+
+struct Reader {
+    pthread_t thread;
+    int dev;
+    long *latencyUs; long samples, capacity;
+    struct CodeCount codes[MAX_CODES]; int codeCount;
+};
+
+struct Device { const char *path; enum DevKind kind; };
+
+static struct Device devices[MAX_DEVICES];
+static int deviceCount = 0;
+static double rate = 1.0;               // reads per second per thread, 0 = back to back
+static volatile sig_atomic_t running = 1;
+
+static double nowSec(void) { struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts); return ts.tv_sec + ts.tv_nsec * 1e-9; }
+static void onSignal(int sig) { (void)sig; running = 0; }
+
+static void countCode(struct Reader *r, const char *code, long n) {
+    for (int i = 0; i < r->codeCount; i++) if (strcmp(r->codes[i].code, code) == 0) { r->codes[i].count += n; return; }
+    if (r->codeCount == MAX_CODES - 1 && strcmp(code, "other") != 0) { countCode(r, "other", n); return; }   // last slot collects the rest
+    snprintf(r->codes[r->codeCount].code, sizeof(r->codes[0].code), "%s", code); r->codes[r->codeCount++].count = n;
+}
+
+static const char *errnoName(int err) {
+    switch (err) {
+    case EIO: return "EIO"; case ENXIO: return "ENXIO"; case ENODEV: return "ENODEV"; case ENOENT: return "ENOENT";
+    case EFAULT: return "EFAULT"; case ETIMEDOUT: return "ETIMEDOUT"; case EAGAIN: return "EAGAIN"; case EBUSY: return "EBUSY";
+    case EINTR: return "EINTR"; case EREMOTEIO: return "EREMOTEIO"; case EOPNOTSUPP: return "EOPNOTSUPP"; case EACCES: return "EACCES";
+    default: return NULL;
+    }
+}
+
+static void errnoCode(char *out, size_t len, const char *op, int err) {
+    const char *name = errnoName(err);
+    if (name) snprintf(out, len, "%s %s", op, name); else snprintf(out, len, "%s errno %d", op, err);
+}
+
+// One read exactly like ZonePipeline: open, read the text line, close
+static void readOnce(struct Reader *r) {
+    const struct Device *d = &devices[r->dev];
+    char buf[64] = {0}, code[24] = "ok"; float a, b; int dhtCode;
+    double t0 = nowSec();
+    int fd = open(d->path, O_RDONLY);
+    if (fd < 0) errnoCode(code, sizeof(code), "open", errno);
+    else {
+        ssize_t n = read(fd, buf, sizeof(buf) - 1);
+        if (n < 0) errnoCode(code, sizeof(code), "read", errno);
+        else if (d->kind == DEV_DHT11) {
+            if (sscanf(buf, "Error reading DHT11: Code %d", &dhtCode) == 1) snprintf(code, sizeof(code), "dht %d", dhtCode);
+            else if (sscanf(buf, "Temp: %f C, Hum: %f %%", &a, &b) != 2) strcpy(code, "parse");
+        } else if (n == 0 || sscanf(buf, "%f", &a) != 1) strcpy(code, "parse");
+        close(fd);
+    }
+    long us = (long)((nowSec() - t0) * 1e6);
+    if (r->samples == r->capacity) { r->capacity = r->capacity ? r->capacity * 2 : 4096; r->latencyUs = realloc(r->latencyUs, r->capacity * sizeof(long)); }
+    r->latencyUs[r->samples++] = us;
+    countCode(r, code, 1);
+}
+
+static void *readerMain(void *arg) {
+    struct Reader *r = arg;
+    struct timespec next; clock_gettime(CLOCK_MONOTONIC, &next);
+    long periodNs = rate > 0 ? (long)(1e9 / rate) : 0;
+    while (running) {
+        readOnce(r);
+        if (periodNs == 0) continue;
+        next.tv_nsec += periodNs; while (next.tv_nsec >= 1000000000L) { next.tv_nsec -= 1000000000L; next.tv_sec++; }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+    return NULL;
+}
+
+// --- Stress generators ---
+
+static void *cpuStress(void *arg) { (void)arg; volatile unsigned long x = 0; while (running) x = x * 6364136223846793005UL + 1; return NULL; }
+
+// hrtimer interrupts (short sleeps) plus NET_RX softirqs (UDP over loopback), like a busy Wi-Fi link
+static void *irqStress(void *arg) {
+    (void)arg; char packet[1400] = {0};
+    int s = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in to; memset(&to, 0, sizeof(to)); to.sin_family = AF_INET; to.sin_port = htons(9); to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    struct timespec shortSleep = {0, 20000};
+    while (running) {
+        nanosleep(&shortSleep, NULL);
+        if (s >= 0) for (int i = 0; i < 8; i++) sendto(s, packet, sizeof(packet), MSG_DONTWAIT, (struct sockaddr *)&to, sizeof(to));
+    }
+    if (s >= 0) close(s);
+    return NULL;
+}
+
+static const char *ioDir = "/tmp";
+static void *ioStress(void *arg) {
+    char path[256], *chunk = calloc(1, IO_CHUNK);
+    snprintf(path, sizeof(path), "%s/sensor_bench_io_%ld.tmp", ioDir, (long)(intptr_t)arg);
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) { fprintf(stderr, "I/O stress: cannot create %s: %s\n", path, strerror(errno)); free(chunk); return NULL; }
+    long written = 0;
+    while (running) {
+        if (write(fd, chunk, IO_CHUNK) != IO_CHUNK) break;
+        fsync(fd); written += IO_CHUNK;
+        if (written >= 64L * 1024 * 1024) { lseek(fd, 0, SEEK_SET); written = 0; }   // stay within 64 MB
+    }
+    close(fd); unlink(path); free(chunk);
+    return NULL;
+}
+
+// --- Report ---
+
+static int cmpLong(const void *a, const void *b) { long x = *(const long *)a, y = *(const long *)b; return (x > y) - (x < y); }
+
+static long sysfsValue(const struct Device *d, const char *which) {
+    char path[256], *name = strdup(d->path); long v = -1;
+    snprintf(path, sizeof(path), DHT_SYSFS, basename(name), which); free(name);
+    FILE *f = fopen(path, "r"); if (f) { if (fscanf(f, "%ld", &v) != 1) v = -1; fclose(f); }
+    return v;
+}
+
+static void resetIrqOff(const struct Device *d) {
+    char path[256], *name = strdup(d->path);
+    snprintf(path, sizeof(path), DHT_SYSFS, basename(name), "max"); free(name);
+    FILE *f = fopen(path, "w"); if (f) { fputs("0\n", f); fclose(f); }
+}
+
+static void report(int dev, struct Reader *readers, int readerCount, double seconds) {
+    long total = 0, ok = 0;
+    for (int i = 0; i < readerCount; i++) if (readers[i].dev == dev) total += readers[i].samples;
+    long *all = malloc((total ? total : 1) * sizeof(long)); long k = 0;
+    struct Reader merged; memset(&merged, 0, sizeof(merged));
+    for (int i = 0; i < readerCount; i++) {
+        if (readers[i].dev != dev) continue;
+        memcpy(all + k, readers[i].latencyUs, readers[i].samples * sizeof(long)); k += readers[i].samples;
+        for (int c = 0; c < readers[i].codeCount; c++) countCode(&merged, readers[i].codes[c].code, readers[i].codes[c].count);
+    }
+    qsort(all, total, sizeof(long), cmpLong);
+    for (int c = 0; c < merged.codeCount; c++) if (strcmp(merged.codes[c].code, "ok") == 0) ok = merged.codes[c].count;
+
+    printf("%s\n", devices[dev].path);
+    if (total == 0) { printf("  no reads\n"); free(all); return; }
+    printf("  reads %ld, ok %ld (%.1f%%), %.2f samples/s, %.2f reads/s\n", total, ok, 100.0 * ok / total, ok / seconds, total / seconds);
+    printf("  latency us: min %ld  p50 %ld  p90 %ld  p99 %ld  max %ld  jitter(p99-p50) %ld\n",
+           all[0], all[total / 2], all[(long)(total * 0.90)], all[(long)(total * 0.99)], all[total - 1], all[(long)(total * 0.99)] - all[total / 2]);
+    printf("  outcomes:");
+    for (int c = 0; c < merged.codeCount; c++) printf("  %s=%ld", merged.codes[c].code, merged.codes[c].count);
+    printf("\n");
+    if (devices[dev].kind == DEV_DHT11) {
+        long maxUs = sysfsValue(&devices[dev], "max");
+        if (maxUs >= 0) printf("  irq-off us: max %ld, last %ld\n", maxUs, sysfsValue(&devices[dev], "last"));
+    }
+    free(all);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-d dev]... [-r rate] [-t threads] [-n seconds] [-c cpu] [-i irq] [-o io] [-T dir]\n"
+                    "  -d  device node, repeatable (default " DEFAULT_DHT " and " DEFAULT_BH ")\n"
+                    "  -r  reads per second per thread, 0 = back to back (default 1)\n"
+                    "  -t  reader threads per device (default 1)\n"
+                    "  -n  duration in seconds (default 30)\n"
+                    "  -c  CPU stress threads   -i  interrupt stress threads (timers + loopback UDP)\n"
+                    "  -o  I/O stress threads (write + fsync in -T dir, default /tmp)\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+    int threads = 1, cpu = 0, irq = 0, io = 0, opt; double seconds = 30;
+    while ((opt = getopt(argc, argv, "d:r:t:n:c:i:o:T:h")) != -1) {
+        switch (opt) {
+        case 'd': if (deviceCount < MAX_DEVICES) devices[deviceCount++].path = optarg; break;
+        case 'r': rate = atof(optarg); break;
+        case 't': threads = atoi(optarg); break;
+        case 'n': seconds = atof(optarg); break;
+        case 'c': cpu = atoi(optarg); break;
+        case 'i': irq = atoi(optarg); break;
+        case 'o': io = atoi(optarg); break;
+        case 'T': ioDir = optarg; break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (deviceCount == 0) { devices[deviceCount++].path = DEFAULT_DHT; devices[deviceCount++].path = DEFAULT_BH; }
+    if (threads < 1 || rate < 0 || seconds <= 0 || cpu < 0 || irq < 0 || io < 0 || deviceCount * threads > MAX_THREADS) { usage(argv[0]); return 2; }
+    for (int d = 0; d < deviceCount; d++) {
+        devices[d].kind = strstr(devices[d].path, "dht11") ? DEV_DHT11 : DEV_BH1750;
+        if (access(devices[d].path, R_OK) != 0) { fprintf(stderr, "%s: %s\n", devices[d].path, strerror(errno)); return 1; }
+        if (devices[d].kind == DEV_DHT11) resetIrqOff(&devices[d]);
+    }
+    signal(SIGINT, onSignal); signal(SIGTERM, onSignal);
+
+    char rateText[32]; if (rate > 0) snprintf(rateText, sizeof(rateText), "%.1f reads/s", rate); else strcpy(rateText, "full speed");
+    printf("%d device(s), %d thread(s) each at %s, %.0f s, stress: cpu %d irq %d io %d\n", deviceCount, threads, rateText, seconds, cpu, irq, io);
+    fflush(stdout);
+
+    int stressCount = cpu + irq + io; pthread_t *stress = calloc(stressCount ? stressCount : 1, sizeof(pthread_t)); int s = 0;
+    for (int i = 0; i < cpu; i++) pthread_create(&stress[s++], NULL, cpuStress, NULL);
+    for (int i = 0; i < irq; i++) pthread_create(&stress[s++], NULL, irqStress, NULL);
+    for (int i = 0; i < io; i++) pthread_create(&stress[s++], NULL, ioStress, (void *)(intptr_t)i);
+
+    int readerCount = deviceCount * threads; struct Reader *readers = calloc(readerCount, sizeof(struct Reader));
+    double t0 = nowSec();
+    for (int i = 0; i < readerCount; i++) { readers[i].dev = i / threads; pthread_create(&readers[i].thread, NULL, readerMain, &readers[i]); }
+    while (running && nowSec() - t0 < seconds) usleep(100000);
+    running = 0;
+    for (int i = 0; i < readerCount; i++) pthread_join(readers[i].thread, NULL);
+    double elapsed = nowSec() - t0;
+    for (int i = 0; i < s; i++) pthread_join(stress[i], NULL);
+
+    for (int d = 0; d < deviceCount; d++) report(d, readers, readerCount, elapsed);
+    for (int i = 0; i < readerCount; i++) free(readers[i].latencyUs);
+    free(readers); free(stress);
+    return 0;
+}
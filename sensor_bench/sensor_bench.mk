@@ -0,0 +1,25 @@
+################################################################################
+#
+# sensor_bench
+#
+################################################################################
+
+SENSOR_BENCH_VERSION = 1.0
+SENSOR_BENCH_SITE = $(TOPDIR)/package/sensor_bench
+SENSOR_BENCH_SITE_METHOD = local
+
+# Đo latency/jitter của driver: build cùng các package driver để cùng phiên bản
+SENSOR_BENCH_DEPENDENCIES = \
+	$(if $(BR2_PACKAGE_DHT11_DRIVER),dht11_driver) \
+	$(if $(BR2_PACKAGE_BH1750_DRIVER),bh1750_driver)
+
+define SENSOR_BENCH_BUILD_CMDS
+    $(TARGET_MAKE_ENV) $(MAKE) CC="$(TARGET_CC)" CFLAGS="$(TARGET_CFLAGS)" -C $(@D)
+endef
+
+define SENSOR_BENCH_INSTALL_TARGET_CMDS
+    $(INSTALL) -D -m 0755 $(@D)/sensor_bench $(TARGET_DIR)/usr/bin/sensor_bench
+    $(INSTALL) -D -m 0755 $(@D)/sensor_bench_sim.sh $(TARGET_DIR)/usr/bin/sensor_bench_sim.sh
+endef
+
+$(eval $(generic-package))
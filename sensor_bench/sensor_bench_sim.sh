@@ -0,0 +1,55 @@
+#!/bin/sh
+# Chạy sensor_bench không cần cảm biến thật (CI / máy dev):
+#  - BH1750 trên i2c-stub (adapter SMBus giả, chip ở 0x23, thanh ghi 0 = giá trị đo)
+#  - DHT11 trên một line gpio-sim kéo lên: driver chạy trọn đường đọc (start pulse,
+#    tắt ngắt, timeout) và trả "Code -1", đủ để đo latency, jitter và thời gian tắt ngắt
+# Cần root, configfs, các module i2c-stub, gpio-sim, dht11_driver, bh1750_driver.
+# Usage: sensor_bench_sim.sh [tham số sensor_bench...], vd. sensor_bench_sim.sh -r 5 -t 2 -c 2 -i 2 -n 60
+
+SIM=/sys/kernel/config/gpio-sim/sensor_bench
+BENCH=${BENCH:-sensor_bench}
+
+cleanup() {
+    rmmod bh1750_driver 2>/dev/null; rmmod dht11_driver 2>/dev/null
+    if [ -d $SIM ]; then echo 0 > $SIM/live; rmdir $SIM/bank0 $SIM; fi
+    rmmod i2c-stub 2>/dev/null
+}
+fail() { echo "sensor_bench_sim: $*" >&2; cleanup; exit 1; }
+trap cleanup INT TERM
+
+# 1. BH1750 trên i2c-stub
+rmmod bh1750_driver 2>/dev/null
+modprobe i2c-stub chip_addr=0x23 || fail "i2c-stub not available"
+BUS=""
+for d in /sys/bus/i2c/devices/i2c-*; do grep -q "SMBus stub" $d/name 2>/dev/null && BUS=${d##*-}; done
+[ -n "$BUS" ] || fail "i2c-stub bus not found"
+# i2c-stub giữ word đúng như i2cset ghi, driver đọc bằng read_word_swapped (byte cao trước như BH1750):
+# ghi 0xf401 để driver nhận raw 0x01f4 = 500 -> 416.66 lux
+command -v i2cset >/dev/null || fail "i2cset (i2c-tools) not found"
+i2cset -y $BUS 0x23 0x00 0xf401 w || fail "cannot seed the i2c-stub register"
+modprobe bh1750_driver bus=$BUS || fail "bh1750_driver did not load on bus $BUS"
+
+# 2. DHT11 trên gpio-sim
+rmmod dht11_driver 2>/dev/null
+modprobe gpio-sim || fail "gpio-sim not available"
+mkdir -p $SIM/bank0 || fail "configfs not mounted"
+echo 1 > $SIM/bank0/num_lines
+echo 1 > $SIM/live || fail "cannot enable gpio-sim"
+CHIP=$(cat $SIM/bank0/chip_name)
+echo pull-up > /sys/devices/platform/$(cat $SIM/dev_name)/$CHIP/sim_gpio0/pull
+BASE=$(cat /sys/class/gpio/$CHIP/base 2>/dev/null || sed -n "s/^$CHIP: GPIOs \([0-9]*\)-.*/\1/p" /sys/kernel/debug/gpio 2>/dev/null)
+[ -n "$BASE" ] || fail "cannot find the GPIO number of $CHIP (needs GPIO sysfs or debugfs)"
+modprobe dht11_driver gpios=$BASE || fail "dht11_driver did not load on GPIO $BASE"
+
+# 3. Đo
+DHT=$(ls /dev/dht11-* | head -n 1)
+# Không pipe qua tee: sh không có pipefail, $? sẽ là của tee
+$BENCH -d $DHT -d /dev/bh1750 "$@" > /tmp/sensor_bench_sim.log 2>&1
+RET=$?
+cat /tmp/sensor_bench_sim.log
+LUX=$(cat /dev/bh1750 2>/dev/null)
+cleanup
+# BH1750 trên stub phải đọc được và ra đúng giá trị đã đặt; DHT11 trên gpio-sim chỉ cần có số liệu
+grep -A1 "^/dev/bh1750" /tmp/sensor_bench_sim.log | grep -q "ok [1-9]" || { echo "sensor_bench_sim: no valid BH1750 reads" >&2; exit 1; }
+[ "$LUX" = "416.66" ] || { echo "sensor_bench_sim: /dev/bh1750 read '$LUX', expected 416.66" >&2; exit 1; }
+exit $RET